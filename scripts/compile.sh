@@ -9,7 +9,20 @@ PROJECT_PATH=./project
 GREEN='\033[0;32m'
 NC='\033[0m'
 
-echo -e "${GREEN}Compiling ...${NC}"
+# ./scripts/compile.sh --lean builds the size optimized variant
+CXXFLAGS=""
+if [ "$1" == "--lean" ]; then
+    CXXFLAGS="-O=s"
+fi
 
-eosiocpp $PROJECT_PATH/src/BancorConverterMigration/BancorConverterMigration.cpp -o $PROJECT_PATH/build/BancorConverterMigration/BancorConverterMigration.wasm --abigen -I.
-eosiocpp $PROJECT_PATH/src/LegacyBancorConverter/LegacyBancorConverter.cpp -o $PROJECT_PATH/build/LegacyBancorConverter/LegacyBancorConverter.wasm --abigen -I.
+echo -e "${GREEN}Compiling ${CXXFLAGS:+(lean) }...${NC}"
+
+eosiocpp $PROJECT_PATH/src/BancorConverterMigration/BancorConverterMigration.cpp -o $PROJECT_PATH/build/BancorConverterMigration/BancorConverterMigration.wasm --abigen -I. $CXXFLAGS
+eosiocpp $PROJECT_PATH/src/LegacyBancorConverter/LegacyBancorConverter.cpp $PROJECT_PATH/src/includes/Common/common.cpp -o $PROJECT_PATH/build/LegacyBancorConverter/LegacyBancorConverter.wasm --abigen -I. $CXXFLAGS
+
+# strips what the optimizer left behind, when binaryen is installed
+if [ -n "$CXXFLAGS" ] && command -v wasm-opt > /dev/null; then
+    for wasm in ./build/BancorConverterMigration/BancorConverterMigration.wasm ./build/LegacyBancorConverter/LegacyBancorConverter.wasm; do
+        wasm-opt -Oz $wasm -o $wasm
+    done
+fi
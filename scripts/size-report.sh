@@ -0,0 +1,30 @@
+#!/bin/bash
+# appends the size of each contract and its largest functions to build/size-report.txt
+# function names are only available for builds that keep the name section (twiggy falls back to code[index])
+
+REPORT=./build/size-report.txt
+CONTRACTS="BancorConverterMigration LegacyBancorConverter"
+TOP_FUNCTIONS=${TOP_FUNCTIONS:-25}
+
+GREEN='\033[0;32m'
+NC='\033[0m'
+
+echo -e "${GREEN}Writing size report to $REPORT ...${NC}"
+
+{
+    echo "==== $(date -u +%Y-%m-%dT%H:%M:%SZ) $(git rev-parse --short HEAD 2> /dev/null)"
+    for contract in $CONTRACTS; do
+        wasm=./build/$contract/$contract.wasm
+        echo "-- $contract: $(wc -c < $wasm) bytes"
+        if command -v twiggy > /dev/null; then
+            twiggy top -n $TOP_FUNCTIONS $wasm
+        elif command -v wasm-objdump > /dev/null; then
+            wasm-objdump -h $wasm | grep -E "^ +[A-Za-z]+ +start"
+        else
+            echo "twiggy or wasm-objdump is required for a per function breakdown"
+        fi
+    done
+    echo
+} >> $REPORT
+
+tail -n +$(grep -n "^====" $REPORT | tail -1 | cut -d: -f1) $REPORT
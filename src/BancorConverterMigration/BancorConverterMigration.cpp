@@ -2,7 +2,6 @@
 #include "BancorConverterMigration.hpp"
 
 #include "../includes/Token.hpp"
-#include "../lib/math_utils.cpp"
 
 inline BancorConverterMigration::BancorConverterMigration(name receiver, name code, datastream<const char *> ds):contract(receiver, code, ds),
     st(receiver, receiver.value),
@@ -10,83 +9,78 @@ inline BancorConverterMigration::BancorConverterMigration(name receiver, name co
 
 
 void BancorConverterMigration::liquidate_old_converter(symbol_code converter_currency_sym){
-    converters converters_table(get_self(), converter_currency_sym.raw());
+    converters converters_table(get_self(), get_self().value);
     const converter_t& converter = converters_table.get(converter_currency_sym.raw(), "[liquidate_old_converter] converter_currency wasn't found");
 
     const LegacyBancorConverter::settings_t& settings = get_original_converter_settings(converter);
-    action(
-        permission_level{ converter.account, "active"_n },
-        converter.account, "update"_n,
-        make_tuple(settings.smart_enabled, settings.enabled, settings.require_balance, uint64_t(0))
-    ).send();
+    update_original_fee(converter, settings, 0);
 
     const vector<LegacyBancorConverter::reserve_t> reserves = get_original_reserves(converter);
-    uint8_t reserve_index = 0;
+    // the migration waits for as many liquidated reserves as the registry counted
+    migrations migrations_table(get_self(), get_self().value);
+    check(reserves.size() == migrations_table.get().reserves_count, "the reserves of the converter changed since its registration, see refreshsym");
     asset old_pool_tokens = Token::get_balance(settings.smart_contract, get_self(), settings.smart_currency.symbol.code());
+    const vector<int64_t> liquidation_amounts = calculate_liquidation_amounts(get_original_supply(settings), old_pool_tokens.amount, reserves);
 
-    asset first_reserve_liquidation_amount;
-    for (const LegacyBancorConverter::reserve_t& reserve : reserves) {
-        string lowest_asset = asset(1, reserve.currency.symbol).to_string();
+    for (size_t reserve_index = 0; reserve_index < reserves.size(); reserve_index++)
+        liquidate_reserve(converter, settings, reserves[reserve_index], liquidation_amounts[reserve_index]);
+    update_original_fee(converter, settings, settings.fee);
+
+    increment_converter_stage(converter_currency_sym);
+}
 
-        string conversion_path = converter.account.to_string() + " " + reserve.currency.symbol.code().to_string();
-        string min_return = lowest_asset.erase(lowest_asset.find(" "));
-        string memo = "1," + conversion_path + "," + min_return + "," + get_self().to_string();
+// sells `amount` old pool tokens for a reserve of the old converter, through the network
+void BancorConverterMigration::liquidate_reserve(const converter_t& converter, const LegacyBancorConverter::settings_t& settings, const LegacyBancorConverter::reserve_t& reserve, int64_t amount) {
+    string lowest_asset = asset(1, reserve.currency.symbol).to_string();
 
-        asset liquidation_amount;
-        if (reserve_index == 0) {
-            asset supply = Token::get_supply(settings.smart_contract, settings.smart_currency.symbol.code());
-            first_reserve_liquidation_amount = asset(calculate_first_reserve_liquidation_amount(supply.amount, old_pool_tokens.amount), old_pool_tokens.symbol);
-            liquidation_amount = first_reserve_liquidation_amount;
-        }
-        else {
-            liquidation_amount = old_pool_tokens - first_reserve_liquidation_amount;
-        }
-        reserve_index++;
+    string conversion_path = converter.account.to_string() + " " + reserve.currency.symbol.code().to_string();
+    string min_return = lowest_asset.erase(lowest_asset.find(" "));
+    string memo = "1," + conversion_path + "," + min_return + "," + get_self().to_string();
 
-        action(
-            permission_level{ get_self(), "active"_n },
-            settings.smart_contract, "transfer"_n,
-            make_tuple(get_self(), p_global_settings->network, liquidation_amount, memo)
-        ).send();
-    }
+    asset liquidation_amount = asset(amount, settings.smart_currency.symbol);
+    action(
+        permission_level{ get_self(), "active"_n },
+        settings.smart_contract, "transfer"_n,
+        make_tuple(get_self(), p_global_settings->network, liquidation_amount, memo)
+    ).send();
+}
+
+// sets the fee of the old converter, which is disabled while its reserves are liquidated
+void BancorConverterMigration::update_original_fee(const converter_t& converter, const LegacyBancorConverter::settings_t& settings, uint64_t fee) {
     action(
         permission_level{ converter.account, "active"_n },
         converter.account, "update"_n,
-        make_tuple(settings.smart_enabled, settings.enabled, settings.require_balance, settings.fee)
+        make_tuple(settings.smart_enabled, settings.enabled, settings.require_balance, fee)
     ).send();
-
-    increment_converter_stage(converter_currency_sym);
 }
 
+// schedules the funding of the new converter with the liquidated reserves
+void BancorConverterMigration::fund_new_converter(const migration_t& migration) {
+    action(
+        permission_level{ get_self(), "active"_n },
+        get_self(), migration.converter_exists ? "fundexisting"_n : "fundnew"_n,
+        make_tuple(migration.old_pool_token.code())
+    ).send();
+}
 
 ACTION BancorConverterMigration::fundexisting(symbol_code converter_currency_sym) {
     require_auth(get_self());
     check(p_global_settings != st.end(), "settings must be initialized");
     
     migrations migrations_table(get_self(), get_self().value);
-    converters converters_table(get_self(), converter_currency_sym.raw());
-    const converter_t& converter_currency = converters_table.get(converter_currency_sym.raw(), "[fundexisting] converter_currency wasn't found");
     const migration_t& migration = migrations_table.get();
     
     BancorConverter::converters new_converters_table(p_global_settings->bancor_converter, migration.new_pool_token.raw());
     const BancorConverter::converter_t& converter = new_converters_table.get(migration.new_pool_token.raw(), "converter not found");
-    
 
-    double funding_pool_return = std::numeric_limits<double>::infinity();
-    reserve_balances reserve_balances_table(get_self(), converter_currency_sym.raw());
-    auto reserve_balance = reserve_balances_table.begin();
-    while (reserve_balance != reserve_balances_table.end()) {
-        double supply = Token::get_supply(p_global_settings->multi_token, migration.new_pool_token).amount;
-        double converter_reserve_balance = get_new_converter_reserve(migration.new_pool_token, reserve_balance->reserve.quantity.symbol.code()).balance.amount;
-        funding_pool_return = std::min(funding_pool_return, calculate_fund_pool_return(reserve_balance->reserve.quantity.amount, converter_reserve_balance, supply));
-        
+    int64_t funding_pool_return = get_funding_pool_return(migration.new_pool_token, migration.liquidated_reserves);
+    for (const extended_asset& reserve : migration.liquidated_reserves) {
         string memo = "fund;" + migration.new_pool_token.to_string();
         action(
             permission_level{ get_self(), "active"_n },
-            reserve_balance->reserve.contract, "transfer"_n,
-            make_tuple(get_self(), p_global_settings->bancor_converter, reserve_balance->reserve.quantity, memo)
+            reserve.contract, "transfer"_n,
+            make_tuple(get_self(), p_global_settings->bancor_converter, reserve.quantity, memo)
         ).send();
-        reserve_balance = reserve_balances_table.erase(reserve_balance);
     }
 
     increment_converter_stage(converter_currency_sym);
@@ -97,21 +91,11 @@ ACTION BancorConverterMigration::fundexisting(symbol_code converter_currency_sym
         p_global_settings->bancor_converter, "fund"_n,
         make_tuple(get_self(), funding_amount)
     ).send();
-    action(
-        permission_level{ get_self(), "active"_n },
-        get_self(), "refundrsrvs"_n,
-        make_tuple(converter_currency_sym)
-    ).send();
     
+    // the refunds and the new pool tokens are only known once `fund` is executed
     action(
         permission_level{ get_self(), "active"_n },
-        get_self(), "transferpool"_n,
-        make_tuple(migration.migration_initiator, migration.new_pool_token)
-    ).send();
-
-    action(
-        permission_level{ get_self(), "active"_n },
-        get_self(), "assertsucess"_n,
+        get_self(), "finalize"_n,
         make_tuple(converter_currency_sym)
     ).send();
 }
@@ -121,105 +105,220 @@ ACTION BancorConverterMigration::fundnew(symbol_code converter_currency_sym) {
     check(p_global_settings != st.end(), "settings must be initialized");
 
     migrations migrations_table(get_self(), get_self().value);
-    converters converters_table(get_self(), converter_currency_sym.raw());
-    const converter_t& converter_currency = converters_table.get(converter_currency_sym.raw(), "[fundnew] converter_currency wasn't found");
     const migration_t& migration = migrations_table.get();
     
-    reserve_balances reserve_balances_table(get_self(), converter_currency_sym.raw());
-    auto reserve_balance = reserve_balances_table.begin();
-    while (reserve_balance != reserve_balances_table.end()) {
+    for (const extended_asset& reserve : migration.liquidated_reserves) {
         const string memo = "fund;" + migration.new_pool_token.to_string();
         action(
             permission_level{ get_self(), "active"_n },
-            reserve_balance->reserve.contract, "transfer"_n,
-            make_tuple(get_self(), p_global_settings->bancor_converter, reserve_balance->reserve.quantity, memo)
+            reserve.contract, "transfer"_n,
+            make_tuple(get_self(), p_global_settings->bancor_converter, reserve.quantity, memo)
         ).send();
-
-        reserve_balance = reserve_balances_table.erase(reserve_balance);
     }
     action(
         permission_level{ get_self(), "active"_n },
         p_global_settings->bancor_converter, "updateowner"_n,
         make_tuple(migration.new_pool_token, migration.migration_initiator)
     ).send();
-    action(
-        permission_level{ get_self(), "active"_n },
-        get_self(), "transferpool"_n,
-        make_tuple(migration.migration_initiator, migration.new_pool_token)
-    ).send();
+
+    // the new pool tokens were issued when the converter was created
+    transfer_pool_tokens(migration);
 
     increment_converter_stage(converter_currency_sym);
-    action(
-        permission_level{ get_self(), "active"_n },
-        get_self(), "assertsucess"_n,
-        make_tuple(converter_currency_sym)
-    ).send();
+    assert_success(converter_currency_sym);
 }
 
-ACTION BancorConverterMigration::transferpool(name to, symbol_code pool_tokens) {
+ACTION BancorConverterMigration::finalize(symbol_code converter_sym) {
     require_auth(get_self());
     check(p_global_settings != st.end(), "settings must be initialized");
+    
+    migrations migrations_table(get_self(), get_self().value);
+    const migration_t migration = migrations_table.get();
+    check(migration.stage == EMigrationStage::DONE, "cannot finalize migation while it's still in progress");
+
+    refund_reserves(migration);
+    transfer_pool_tokens(migration);
+    assert_success(converter_sym);
+}
+
+ACTION BancorConverterMigration::assertsucess(symbol_code converter_sym) {
+    require_auth(get_self());
+    check(p_global_settings != st.end(), "settings must be initialized");
+
+    migrations migrations_table(get_self(), get_self().value);
+    const migration_t migration = migrations_table.get();
+    check(migration.stage == EMigrationStage::DONE, "cannot clear migation while it's still in progress");
+
+    assert_migration_balances(get_converter(converter_sym), migration);
+    migrations_table.remove();
+}
+
+ACTION BancorConverterMigration::migstep(symbol_code converter_sym) {
+    check(p_global_settings != st.end(), "settings must be initialized");
+
+    chunked_migrations chunked_migrations_table(get_self(), get_self().value);
+    const migration_t& chunked_migration = chunked_migrations_table.get(converter_sym.raw(), "no chunked migration of this converter");
+    require_auth(chunked_migration.migration_initiator);
+    migration_t migration = chunked_migration;
+
+    const converter_t& converter = get_converter(converter_sym);
+    const LegacyBancorConverter::settings_t& settings = get_original_converter_settings(converter);
+    const vector<LegacyBancorConverter::reserve_t> reserves = get_original_reserves(converter);
+    migration_cursor cursor = migration.cursor.value();
+    check_unchanged_reserves(cursor, reserves);
+
+    // the creation of the new converter and of its reserves when it does not exist yet, a step each
+    const size_t creation_steps = migration.converter_exists ? 0 : 1 + reserves.size();
+    if (cursor.step < creation_steps) {
+        if (cursor.step == 0)
+            create_new_converter(asset(Token::get_balance(settings.smart_contract, get_self(), converter_sym).amount, migration.old_pool_token), migration.new_pool_token, settings.fee);
+        else
+            set_new_converter_reserve(migration.new_pool_token, reserves[cursor.step - 1]);
+
+        cursor.step++;
+        cursor.deadline = current_time_point().sec_since_epoch() + CHUNKED_MIGRATION_TIMEOUT;
+        chunked_migrations_table.modify(chunked_migration, same_payer, [&](auto& m) {
+            m.cursor.emplace(cursor);
+        });
+        return;
+    }
+
+    // the last step runs the rest of the migration as a single transaction migration does,
+    // every reserve is liquidated and the new converter is funded in this transaction
+    chunked_migrations_table.erase(chunked_migration);
+    migration.cursor.reset();
+    migrations migrations_table(get_self(), get_self().value);
+    migrations_table.set(migration, get_self());
+
+    liquidate_old_converter(converter_sym);
+    fund_new_converter(migration);
+}
+
+ACTION BancorConverterMigration::cancelmig(symbol_code converter_sym) {
+    check(p_global_settings != st.end(), "settings must be initialized");
 
-    asset new_pool_tokens = Token::get_balance(p_global_settings->multi_token, get_self(), pool_tokens);
+    chunked_migrations chunked_migrations_table(get_self(), get_self().value);
+    const auto chunked_migration = chunked_migrations_table.find(converter_sym.raw());
+    check(chunked_migration != chunked_migrations_table.end(), "no chunked migration of this converter");
+    const migration_t migration = *chunked_migration;
+    const converter_t& converter = get_converter(converter_sym);
+
+    if (current_time_point().sec_since_epoch() < migration.cursor.value().deadline)
+        check(has_auth(migration.migration_initiator) || has_auth(converter.owner) || has_auth(get_self()), "missing authority to cancel the migration before its deadline");
+    chunked_migrations_table.erase(chunked_migration);
+
+    const LegacyBancorConverter::settings_t& settings = get_original_converter_settings(converter);
+    const asset old_pool_tokens = Token::get_balance(settings.smart_contract, get_self(), converter_sym);
     action(
         permission_level{ get_self(), "active"_n },
-        p_global_settings->multi_token, "transfer"_n,
-        make_tuple(get_self(), to, new_pool_tokens, string("new converter pool tokens"))
+        settings.smart_contract, "transfer"_n,
+        make_tuple(get_self(), migration.migration_initiator, old_pool_tokens, string("cancelled migration refund"))
     ).send();
+
+    // the new converter was created by the migration, and none of its reserves are funded
+    if (!migration.converter_exists && migration.cursor.value().step > 0) {
+        action(
+            permission_level{ get_self(), "active"_n },
+            p_global_settings->bancor_converter, "updateowner"_n,
+            make_tuple(migration.new_pool_token, converter.owner)
+        ).send();
+
+        const asset new_pool_tokens = Token::get_balance(p_global_settings->multi_token, get_self(), migration.new_pool_token);
+        action(
+            permission_level{ get_self(), "active"_n },
+            p_global_settings->multi_token, "transfer"_n,
+            make_tuple(get_self(), converter.owner, new_pool_tokens, string("new converter pool tokens"))
+        ).send();
+    }
 }
 
-ACTION BancorConverterMigration::refundrsrvs(symbol_code converter_pool_token) {
-    require_auth(get_self());
+ACTION BancorConverterMigration::previewmig(asset quantity) {
     check(p_global_settings != st.end(), "settings must be initialized");
+    const converter_t& converter = get_converter(quantity.symbol.code());
+    check_single_pool(converter);
+    const LegacyBancorConverter::settings_t& settings = get_original_converter_settings(converter);
+    check(quantity.symbol == settings.smart_currency.symbol && quantity.amount > 0, "invalid quantity");
 
-    migrations migrations_table(get_self(), get_self().value);
-    const migration_t& migration = migrations_table.get();
-    
-    BancorConverter::reserves new_converter_reserves_table(p_global_settings->bancor_converter, migration.new_pool_token.raw());
-
-    for (const BancorConverter::reserve_t& reserve : new_converter_reserves_table) {
-        BancorConverter::accounts accounts_balances_table(p_global_settings->bancor_converter, get_self().value);
-
-        const uint128_t secondary_key = BancorConverter::_by_cnvrt(reserve.balance, migration.new_pool_token);
-        const auto index = accounts_balances_table.get_index<"bycnvrt"_n >();
-        const auto account_balance = index.find(secondary_key);
-        
-        if (account_balance != index.end() && account_balance->quantity.amount > 0) {
-            action(
-                permission_level{ get_self(), "active"_n },
-                p_global_settings->bancor_converter, "withdraw"_n,
-                make_tuple(get_self(), account_balance->quantity,migration.new_pool_token)
-            ).send();
-
-            const string memo = "pool tokens migration reserves refund";
-            action(
-                permission_level{ get_self(), "active"_n },
-                reserve.contract, "transfer"_n,
-                make_tuple(get_self(), migration.migration_initiator, account_balance->quantity, memo)
-            ).send();
-        }
+    const symbol_code new_pool_token = get_new_pool_token(converter);
+    const bool converter_exists = does_converter_exist(new_pool_token);
+
+    const vector<LegacyBancorConverter::reserve_t> reserves = get_original_reserves(converter);
+    const int64_t supply = get_original_supply(settings);
+    const vector<int64_t> liquidation_amounts = calculate_liquidation_amounts(supply, quantity.amount, reserves);
+    const vector<int64_t> returns = calculate_liquidation_returns(converter, settings, supply, reserves, liquidation_amounts);
+
+    vector<extended_asset> liquidated_reserves;
+    vector<reserve_preview> reserve_previews;
+    for (size_t i = 0; i < reserves.size(); i++) {
+        const symbol reserve_symbol = reserves[i].currency.symbol;
+        liquidated_reserves.push_back(extended_asset(asset(returns[i], reserve_symbol), reserves[i].contract));
+        reserve_previews.push_back({ reserves[i].contract, reserve_symbol.code(),
+            amount_to_tokens(liquidation_amounts[i], quantity.symbol.precision()), amount_to_tokens(returns[i], reserve_symbol.precision()) });
+    }
+
+    // a new converter is created with a supply of the migrated amount, an existing one is funded with the reserves
+    double new_pool_tokens = amount_to_tokens(quantity.amount, quantity.symbol.precision());
+    if (converter_exists) {
+        BancorConverter::converters new_converters_table(p_global_settings->bancor_converter, new_pool_token.raw());
+        const BancorConverter::converter_t& new_converter = new_converters_table.get(new_pool_token.raw(), "converter not found");
+        new_pool_tokens = amount_to_tokens(get_funding_pool_return(new_pool_token, liquidated_reserves), new_converter.currency.precision());
     }
+
+    EMIT_MIGRATION_PREVIEW_EVENT(amount_to_tokens(quantity.amount, quantity.symbol.precision()), new_pool_token, converter_exists, reserve_previews, new_pool_tokens);
 }
 
 ACTION BancorConverterMigration::addconverter(symbol_code converter_sym, name converter_account, name owner) {
     require_auth(get_self());
-    converters converters_table(get_self(), converter_sym.raw());
+    converters converters_table(get_self(), get_self().value);
     
-    converters_table.emplace(get_self(), [&](auto& cc) {
-        cc.sym = converter_sym;
-        cc.account = converter_account;
-        cc.owner = owner;
-    });
+    add_converter(converters_table, converter_sym, converter_account, owner);
+}
+
+ACTION BancorConverterMigration::addconverters(const vector<converter_entry>& new_converters) {
+    require_auth(get_self());
+    converters converters_table(get_self(), get_self().value);
+
+    for (const converter_entry& converter : new_converters)
+        add_converter(converters_table, converter.sym, converter.account, converter.owner);
 }
 
 ACTION BancorConverterMigration::delconverter(symbol_code converter_sym) {
     require_auth(get_self());
-    converters converters_table(get_self(), converter_sym.raw());
+    converters converters_table(get_self(), get_self().value);
     const converter_t& converter = converters_table.get(converter_sym.raw(), "[delconverter] converter_currency wasn't found");
+    chunked_migrations chunked_migrations_table(get_self(), get_self().value);
+    check_format(chunked_migrations_table.find(converter_sym.raw()) == chunked_migrations_table.end(), "a chunked migration of {} is in progress", converter_sym);
     
     converters_table.erase(converter);
 }
 
+ACTION BancorConverterMigration::rescope(const vector<symbol_code>& converter_syms) {
+    require_auth(get_self());
+    converters converters_table(get_self(), get_self().value);
+
+    for (const symbol_code& converter_sym : converter_syms) {
+        converters former_converters_table(get_self(), converter_sym.raw());
+        const converter_t& converter = former_converters_table.get(converter_sym.raw(), "[rescope] converter_currency wasn't found");
+
+        add_converter(converters_table, converter.sym, converter.account, converter.owner);
+        former_converters_table.erase(converter);
+    }
+}
+
+ACTION BancorConverterMigration::refreshsym(symbol_code converter_sym) {
+    require_auth(get_self());
+    converters converters_table(get_self(), get_self().value);
+    const converter_t& converter = converters_table.get(converter_sym.raw(), "[refreshsym] converter_currency wasn't found");
+
+    const symbol_code new_pool_token = generate_converter_symbol(converter.account);
+    check(new_pool_token.raw() != 0, "couldn't find reserve code");
+    const uint8_t reserves_count = count_original_reserves(converter.account);
+    converters_table.modify(converter, same_payer, [&](auto& cc) {
+        cc.new_pool_token.emplace(new_pool_token);
+        cc.reserves_count.emplace(reserves_count);
+    });
+}
+
 ACTION BancorConverterMigration::setsettings(name bancor_converter, name multi_token, name network) {   
     require_auth(get_self());
 
@@ -243,32 +342,6 @@ ACTION BancorConverterMigration::setsettings(name bancor_converter, name multi_t
     }
 }
 
-ACTION BancorConverterMigration::assertsucess(symbol_code converter_sym) {
-    require_auth(get_self());
-    check(p_global_settings != st.end(), "settings must be initialized");
-    
-    migrations migrations_table(get_self(), get_self().value);
-    converters converters_table(get_self(), converter_sym.raw());
-    const migration_t& migration = migrations_table.get();
-    const converter_t& converter = converters_table.get(converter_sym.raw(), "[assertsucess] converter_currency wasn't found"); 
-    
-    const LegacyBancorConverter::settings_t& settings = get_original_converter_settings(converter);
-    
-    asset old_pool_tokens = Token::get_balance(settings.smart_contract, get_self(), settings.smart_currency.symbol.code());
-    asset new_pool_tokens = Token::get_balance(p_global_settings->multi_token, get_self(), migration.new_pool_token);
-    
-    check(old_pool_tokens.amount == 0, "migration contract's old pool tokens balance is not 0");
-    check(new_pool_tokens.amount == 0, "migration contract's new pool tokens balance is not 0");
-
-    const vector<LegacyBancorConverter::reserve_t> reserves = get_original_reserves(converter);
-    for (const LegacyBancorConverter::reserve_t& reserve : reserves) {
-        asset reserve_balance = Token::get_balance(reserve.contract, get_self(), reserve.currency.symbol.code());
-        check(reserve_balance.amount == 0, "migration contract's reserve tokens balance is not 0");
-    }
-    
-    clear(converter_sym);
-}
-
 void BancorConverterMigration::on_transfer(name from, name to, asset quantity, string memo) {
     check(p_global_settings != st.end(), "settings must be initialized");
 
@@ -277,8 +350,12 @@ void BancorConverterMigration::on_transfer(name from, name to, asset quantity, s
 
     if (memo == "init")
         return;
-    
-    converters converters_table(get_self(), quantity.symbol.code().raw());
+
+    // withdrawals of the temporary balances left after funding an existing converter, received once the migration is finalized
+    if (from == p_global_settings->bancor_converter)
+        return;
+
+    converters converters_table(get_self(), get_self().value);
     migrations migrations_table(get_self(), get_self().value);
 
     uint8_t current_stage = EMigrationStage::INITIAL;
@@ -292,27 +369,28 @@ void BancorConverterMigration::on_transfer(name from, name to, asset quantity, s
 
     switch(current_stage) {
         case EMigrationStage::INITIAL : {
-            const symbol_code new_converter_sym = generate_converter_symbol(quantity.symbol.code());
+            const converter_t& converter = converters_table.get(quantity.symbol.code().raw(), "[on_transfer] converter_currency wasn't found");
+            check_single_pool(converter);
+            const symbol_code new_converter_sym = get_new_pool_token(converter);
+            check_no_chunked_migration(quantity.symbol.code(), new_converter_sym);
             bool converter_exists = does_converter_exist(new_converter_sym);
+            if (memo == "chunked") { // the rest of the migration is run by `migstep`
+                check(get_original_converter_settings(converter).smart_contract == get_first_receiver(), "unknown token contract");
+                if (!converter_exists)
+                    require_auth(converter.owner);
+                park_migration(from, quantity, converter_exists, new_converter_sym);
+                break;
+            }
             init_migration(from, quantity, converter_exists, new_converter_sym);
             if (!converter_exists)
                 create_converter(from, quantity, new_converter_sym);
             liquidate_old_converter(quantity.symbol.code());
-            if (converter_exists)
-                action( 
-                    permission_level{ get_self(), "active"_n },
-                    get_self(), "fundexisting"_n,
-                    make_tuple(quantity.symbol.code()) 
-                ).send();
-            else
-                action( 
-                    permission_level{ get_self(), "active"_n },
-                    get_self(), "fundnew"_n,
-                    make_tuple(quantity.symbol.code())
-                ).send();
+            fund_new_converter(migrations_table.get());
             break;
         }
         case EMigrationStage::LIQUIDATION : {
+            // the liquidated reserves are returned by the network, chunked migrations stay in this stage between transactions
+            check(from == p_global_settings->network, "a migration is in progress");
             handle_liquidated_reserve(from, quantity);
             break;
         }
@@ -329,7 +407,16 @@ void BancorConverterMigration::create_converter(name from, asset quantity, const
     const LegacyBancorConverter::settings_t& settings = get_original_converter_settings(converter);
     check(settings.smart_contract == get_first_receiver(), "unknown token contract");
 
-    double initial_supply = quantity.amount / pow(10, quantity.symbol.precision());
+    create_new_converter(quantity, new_pool_token, settings.fee);
+
+    const vector<LegacyBancorConverter::reserve_t> reserves = get_original_reserves(converter);
+    for (const LegacyBancorConverter::reserve_t& reserve : reserves)
+        set_new_converter_reserve(new_pool_token, reserve);
+}
+
+// creates the new converter with a supply of the migrated pool tokens, and the fee of the old converter
+void BancorConverterMigration::create_new_converter(asset quantity, const symbol_code& new_pool_token, uint64_t fee) {
+    double initial_supply = amount_to_tokens(quantity.amount, quantity.symbol.precision());
     action( 
         permission_level{ get_self(), "active"_n },
         p_global_settings->bancor_converter, "create"_n,
@@ -339,55 +426,89 @@ void BancorConverterMigration::create_converter(name from, asset quantity, const
     action( 
         permission_level{ get_self(), "active"_n },
         p_global_settings->bancor_converter, "updatefee"_n,
-        make_tuple(new_pool_token, settings.fee)
+        make_tuple(new_pool_token, fee)
     ).send();
+}
 
-    const vector<LegacyBancorConverter::reserve_t> reserves = get_original_reserves(converter);
-    for (const LegacyBancorConverter::reserve_t& reserve : reserves) {
-        action(
-            permission_level{ get_self(), "active"_n },
-            p_global_settings->bancor_converter, "setreserve"_n,
-            make_tuple(new_pool_token, reserve.currency.symbol, reserve.contract, reserve.ratio)
-        ).send();
-    }
-
+void BancorConverterMigration::set_new_converter_reserve(const symbol_code& new_pool_token, const LegacyBancorConverter::reserve_t& reserve) {
+    action(
+        permission_level{ get_self(), "active"_n },
+        p_global_settings->bancor_converter, "setreserve"_n,
+        make_tuple(new_pool_token, reserve.currency.symbol, reserve.contract, reserve.ratio)
+    ).send();
 }
 
 void BancorConverterMigration::handle_liquidated_reserve(name from, asset quantity) {
     migrations migrations_table(get_self(), get_self().value);
-    const symbol_code& current_converter = migrations_table.get().old_pool_token.code();
-    if (current_converter == quantity.symbol.code()) return; // ignore pool token issuance notification
+    migration_t migration = migrations_table.get();
+    if (migration.old_pool_token.code() == quantity.symbol.code()) return; // ignore pool token issuance notification
 
-    reserve_balances reserve_balances_table(get_self(), current_converter.raw());
-    const auto reserve = reserve_balances_table.find(quantity.symbol.code().raw());
-    
-    if (reserve == reserve_balances_table.end()) {
-        reserve_balances_table.emplace(get_self(), [&](auto& r) {
-            r.reserve = extended_asset(quantity, get_first_receiver());
-        });
-    }
-    else { check(false, "not supported"); }
+    for (const extended_asset& reserve : migration.liquidated_reserves)
+        check(reserve.quantity.symbol != quantity.symbol, "not supported");
+    migration.liquidated_reserves.push_back(extended_asset(quantity, get_first_receiver()));
 
-    uint8_t reserves_length = std::distance(reserve_balances_table.begin(), reserve_balances_table.end());
-    if (reserves_length >= 2)
-        increment_converter_stage(current_converter);
+    if (migration.liquidated_reserves.size() >= migration.reserves_count)
+        migration.stage++;
+
+    migrations_table.set(migration, get_self());
 }
 
 // helpers
 
 void BancorConverterMigration::init_migration(name from, asset quantity, bool converter_exists, const symbol_code& new_pool_token) {
-    const converter_t& converter = get_converter(quantity.symbol.code());
     migrations migrations_table(get_self(), get_self().value);
-    const migration_t migration = migration_t{
+    migrations_table.set(make_migration(from, quantity, converter_exists, new_pool_token), get_self());
+}
+
+// records a chunked migration, run by `migstep` in the following transactions
+void BancorConverterMigration::park_migration(name from, asset quantity, bool converter_exists, const symbol_code& new_pool_token) {
+    migration_t migration = make_migration(from, quantity, converter_exists, new_pool_token);
+    vector<extended_symbol> reserves;
+    for (const LegacyBancorConverter::reserve_t& reserve : get_original_reserves(get_converter(quantity.symbol.code())))
+        reserves.push_back(extended_symbol(reserve.currency.symbol, reserve.contract));
+    migration.cursor.emplace(migration_cursor{ 0, current_time_point().sec_since_epoch() + CHUNKED_MIGRATION_TIMEOUT, reserves });
+
+    chunked_migrations chunked_migrations_table(get_self(), get_self().value);
+    chunked_migrations_table.emplace(get_self(), [&](auto& m) {
+        m = migration;
+    });
+}
+
+BancorConverterMigration::migration_t BancorConverterMigration::make_migration(name from, asset quantity, bool converter_exists, const symbol_code& new_pool_token) {
+    const converter_t& converter = get_converter(quantity.symbol.code());
+    return migration_t{
         quantity.symbol,
         new_pool_token,
         converter.account,
         EMigrationStage::INITIAL,
         from,
-        converter_exists
+        converter_exists,
+        get_reserves_count(converter),
+        {},
+        binary_extension<migration_cursor>()
     };
-    migrations_table.set(migration, get_self());
 }
+
+// a chunked migration holds the old pool tokens of its converter until its last step,
+// and the new pool tokens of the converter it creates, which other migrations would otherwise take or fund
+void BancorConverterMigration::check_no_chunked_migration(symbol_code converter_sym, symbol_code new_pool_token) {
+    chunked_migrations chunked_migrations_table(get_self(), get_self().value);
+    check_format(chunked_migrations_table.find(converter_sym.raw()) == chunked_migrations_table.end(), "a chunked migration of {} is in progress", converter_sym);
+
+    const auto chunked_migrations_by_new_pool_token = chunked_migrations_table.get_index<"bynewtoken"_n>();
+    check_format(chunked_migrations_by_new_pool_token.find(new_pool_token.raw()) == chunked_migrations_by_new_pool_token.end(),
+        "a chunked migration to {} is in progress", new_pool_token);
+}
+
+// the new pool token, the reserves of the new converter and the liquidated reserves all follow the reserves
+// the old converter had when the chunked migration started
+void BancorConverterMigration::check_unchanged_reserves(const migration_cursor& cursor, const vector<LegacyBancorConverter::reserve_t>& reserves) {
+    bool unchanged = cursor.reserves.size() == reserves.size();
+    for (size_t i = 0; unchanged && i < reserves.size(); i++)
+        unchanged = cursor.reserves[i] == extended_symbol(reserves[i].currency.symbol, reserves[i].contract);
+    check(unchanged, "the reserves of the converter changed since the migration started, it can only be cancelled");
+}
+
 void BancorConverterMigration::increment_converter_stage(symbol_code converter_currency) {
     migrations migrations_table(get_self(), get_self().value);
     migration_t migration = migrations_table.get();
@@ -396,11 +517,90 @@ void BancorConverterMigration::increment_converter_stage(symbol_code converter_c
     migrations_table.set(migration, get_self());
 }
 
-void BancorConverterMigration::clear(symbol_code converter_currency) {
-    migrations migrations_table(get_self(), get_self().value);
-    const migration_t migration_data = migrations_table.get();
-    check(migration_data.stage == EMigrationStage::DONE, "cannot clear migation while it's still in progress");
-    migrations_table.remove();
+void BancorConverterMigration::add_converter(converters& converters_table, symbol_code converter_sym, name converter_account, name owner) {
+    check(converter_sym.is_valid(), "invalid converter symbol");
+    check_format(converters_table.find(converter_sym.raw()) == converters_table.end(), "converter {} already exists", converter_sym);
+
+    const auto converters_by_account = converters_table.get_index<"byaccount"_n >();
+    check_format(converters_by_account.find(converter_account.value) == converters_by_account.end(), "converter account {} is already registered", converter_account);
+    check_single_pool(converter_account);
+    
+    // computed once here rather than on every migration, left unset until the old converter has reserves
+    const symbol_code new_pool_token = generate_converter_symbol(converter_account);
+    converters_table.emplace(get_self(), [&](auto& cc) {
+        cc.sym = converter_sym;
+        cc.account = converter_account;
+        cc.owner = owner;
+        if (new_pool_token.raw() != 0) {
+            cc.new_pool_token.emplace(new_pool_token);
+            cc.reserves_count.emplace(count_original_reserves(converter_account));
+        }
+    });
+}
+
+// sends the migration contract's new pool tokens to the migration initiator
+void BancorConverterMigration::transfer_pool_tokens(const migration_t& migration) {
+    asset new_pool_tokens = Token::get_balance(p_global_settings->multi_token, get_self(), migration.new_pool_token);
+    action(
+        permission_level{ get_self(), "active"_n },
+        p_global_settings->multi_token, "transfer"_n,
+        make_tuple(get_self(), migration.migration_initiator, new_pool_tokens, string("new converter pool tokens"))
+    ).send();
+}
+
+// refunds the reserves that were not used for funding the new converter to the migration initiator
+// the migration contract's temporary balance of each liquidated reserve is looked up by reserve and new pool token
+void BancorConverterMigration::refund_reserves(const migration_t& migration) {
+    BancorConverter::accounts accounts_balances_table(p_global_settings->bancor_converter, get_self().value);
+    const auto accounts_balances_by_converter = accounts_balances_table.get_index<"bycnvrt"_n>();
+
+    vector<extended_asset> refunds;
+    for (const extended_asset& reserve : migration.liquidated_reserves) {
+        const auto account_balance = accounts_balances_by_converter.find(BancorConverter::_by_cnvrt(reserve.quantity, migration.new_pool_token));
+        if (account_balance != accounts_balances_by_converter.end() && account_balance->quantity.amount > 0)
+            refunds.push_back(extended_asset(account_balance->quantity, reserve.contract));
+    }
+
+    for (const extended_asset& refund : refunds)
+        action(
+            permission_level{ get_self(), "active"_n },
+            p_global_settings->bancor_converter, "withdraw"_n,
+            make_tuple(get_self(), refund.quantity, migration.new_pool_token)
+        ).send();
+
+    const string memo = "pool tokens migration reserves refund";
+    for (const extended_asset& refund : refunds)
+        action(
+            permission_level{ get_self(), "active"_n },
+            refund.contract, "transfer"_n,
+            make_tuple(get_self(), migration.migration_initiator, refund.quantity, memo)
+        ).send();
+}
+
+// schedules `assertsucess`, which runs once the refunds and the new pool tokens sent before it are transferred
+void BancorConverterMigration::assert_success(symbol_code converter_sym) {
+    action(
+        permission_level{ get_self(), "active"_n },
+        get_self(), "assertsucess"_n,
+        make_tuple(converter_sym)
+    ).send();
+}
+
+// asserts that the migration contract is left without old pool tokens, new pool tokens and reserve tokens
+void BancorConverterMigration::assert_migration_balances(const converter_t& converter, const migration_t& migration) {
+    const LegacyBancorConverter::settings_t& settings = get_original_converter_settings(converter);
+    
+    asset old_pool_tokens = Token::get_balance(settings.smart_contract, get_self(), settings.smart_currency.symbol.code());
+    check_format(old_pool_tokens.amount == 0, "migration contract's old pool tokens balance is not 0, got {}", old_pool_tokens);
+
+    asset new_pool_tokens = Token::get_balance(p_global_settings->multi_token, get_self(), migration.new_pool_token);
+    check_format(new_pool_tokens.amount == 0, "migration contract's new pool tokens balance is not 0, got {}", new_pool_tokens);
+
+    const vector<LegacyBancorConverter::reserve_t> reserves = get_original_reserves(converter);
+    for (const LegacyBancorConverter::reserve_t& reserve : reserves) {
+        asset reserve_balance = Token::get_balance(reserve.contract, get_self(), reserve.currency.symbol.code());
+        check_format(reserve_balance.amount == 0, "migration contract's reserve tokens balance is not 0, got {}", reserve_balance);
+    }
 }
 
 vector<LegacyBancorConverter::reserve_t> BancorConverterMigration::get_original_reserves(BancorConverterMigration::converter_t converter) {
@@ -414,6 +614,16 @@ vector<LegacyBancorConverter::reserve_t> BancorConverterMigration::get_original_
     return reserves;
 }
 
+uint8_t BancorConverterMigration::count_original_reserves(name converter_account) {
+    LegacyBancorConverter::reserves original_converter_reserves_table(converter_account, converter_account.value);
+    return std::distance(original_converter_reserves_table.begin(), original_converter_reserves_table.end());
+}
+
+// returns the reserves count stored in the registry, or counts the reserves of converters registered before they had any
+uint8_t BancorConverterMigration::get_reserves_count(const converter_t& converter) {
+    return converter.reserves_count.has_value() ? converter.reserves_count.value() : count_original_reserves(converter.account);
+}
+
 const BancorConverter::reserve_t& BancorConverterMigration::get_new_converter_reserve(symbol_code converter_sym, symbol_code reserve_sym) {
     BancorConverter::reserves new_converter_reserves_table(p_global_settings->bancor_converter, converter_sym.raw());
 
@@ -421,11 +631,24 @@ const BancorConverter::reserve_t& BancorConverterMigration::get_new_converter_re
 }
 
 const BancorConverterMigration::converter_t& BancorConverterMigration::get_converter(symbol_code sym) {
-    converters converters_table(get_self(), sym.raw());
+    converters converters_table(get_self(), get_self().value);
     const converter_t& converter_currency = converters_table.get(sym.raw(), "converter not found");
     return converter_currency;
 }
 
+// the old converter's tables are read in the account's own scope, the pools of accounts hosting several pools are scoped by their pool token
+void BancorConverterMigration::check_single_pool(name converter_account) {
+    LegacyBancorConverter::pools pools_table(converter_account, converter_account.value);
+    check_format(pools_table.begin() == pools_table.end(), "converter account {} hosts several pools, which cannot be migrated", converter_account);
+}
+
+// a registry row holding the reserves count was written once the account had reserves in its own scope,
+// it never hosts pools since an account holds either a single pool or hosted pools
+void BancorConverterMigration::check_single_pool(const converter_t& converter) {
+    if (!converter.reserves_count.has_value())
+        check_single_pool(converter.account);
+}
+
 
 const LegacyBancorConverter::settings_t& BancorConverterMigration::get_original_converter_settings(BancorConverterMigration::converter_t converter) {
     LegacyBancorConverter::settings original_converter_settings_table(converter.account, converter.account.value);
@@ -434,21 +657,47 @@ const LegacyBancorConverter::settings_t& BancorConverterMigration::get_original_
     return st;
 }
 
-const symbol_code BancorConverterMigration::generate_converter_symbol(symbol_code old_sym) {
-    converters converters_table(get_self(), old_sym.raw());
-    const converter_t& converter = converters_table.get(old_sym.raw(), "[generate_converter_symbol] converter_currency wasn't found");
-    const vector<LegacyBancorConverter::reserve_t> reserves = get_original_reserves(converter);
-    
-    symbol_code converter_reserve;
-    for (const LegacyBancorConverter::reserve_t& reserve : reserves) {
-        if (reserve.currency.symbol.code() != NETWORK_TOKEN_CODE) {
-            converter_reserve = reserve.currency.symbol.code();
-            break;
-        }
+// returns the supply of the old pool token, including the offset of its converter
+int64_t BancorConverterMigration::get_original_supply(const LegacyBancorConverter::settings_t& settings) {
+    return (Token::get_supply(settings.smart_contract, settings.smart_currency.symbol.code()) + settings.smart_currency).amount;
+}
+
+// returns the new pool tokens of funding an existing converter with `reserves`, as much as the scarcest reserve allows
+int64_t BancorConverterMigration::get_funding_pool_return(symbol_code new_pool_token, const vector<extended_asset>& reserves) {
+    const int64_t supply = Token::get_supply(p_global_settings->multi_token, new_pool_token).amount;
+
+    int64_t funding_pool_return = asset::max_amount;
+    for (const extended_asset& reserve : reserves) {
+        int64_t converter_reserve_balance = get_new_converter_reserve(new_pool_token, reserve.quantity.symbol.code()).balance.amount;
+        funding_pool_return = std::min(funding_pool_return, calculate_fund_pool_return(reserve.quantity.amount, converter_reserve_balance, supply));
     }
-    check(converter_reserve.to_string() != "", "couldn't find reserve code");
-    
-    return symbol_code(converter_reserve.to_string().substr(0, 4) + NETWORK_TOKEN_CODE.to_string());
+    return funding_pool_return;
+}
+
+// returns the new pool token stored in the registry, or computes it for converters registered before they had reserves
+const symbol_code BancorConverterMigration::get_new_pool_token(const converter_t& converter) {
+    const symbol_code new_pool_token = converter.new_pool_token.has_value() ? converter.new_pool_token.value() : generate_converter_symbol(converter.account);
+    check(new_pool_token.raw() != 0, "couldn't find reserve code");
+    return new_pool_token;
+}
+
+// returns the first 4 characters of the first non network token reserve followed by the network token code, or an empty symbol code
+// e.g. - a DDDDD/BNT converter --> DDDDBNT
+const symbol_code BancorConverterMigration::generate_converter_symbol(name converter_account) {
+    LegacyBancorConverter::reserves original_converter_reserves_table(converter_account, converter_account.value);
+    for (const LegacyBancorConverter::reserve_t& reserve : original_converter_reserves_table) {
+        const symbol_code reserve_code = reserve.currency.symbol.code();
+        if (reserve_code == NETWORK_TOKEN_CODE)
+            continue;
+
+        // symbol codes hold one character per byte from the lowest one, so the prefix is the lowest 4 bytes
+        const uint64_t prefix = reserve_code.raw() & 0xFFFFFFFF;
+        uint8_t prefix_length = 0;
+        while (prefix_length < 4 && (prefix >> (8 * prefix_length)) & 0xFF)
+            prefix_length++;
+        return symbol_code(prefix | (NETWORK_TOKEN_CODE.raw() << (8 * prefix_length)));
+    }
+    return symbol_code();
 }
 
 bool BancorConverterMigration::does_converter_exist(symbol_code sym) {
@@ -456,30 +705,75 @@ bool BancorConverterMigration::does_converter_exist(symbol_code sym) {
     return new_converters_table.find(sym.raw()) != new_converters_table.end();
 }
 
-double BancorConverterMigration::calculate_first_reserve_liquidation_amount(double pool_token_supply, double quantity) {
-    const double a = 1;
-    const double b = -2 * pool_token_supply;
-    const double c = quantity * pool_token_supply;
-    const auto [x1, x2] = find_quadratic_roots(a, b, c);
+vector<int64_t> BancorConverterMigration::calculate_liquidation_amounts(double pool_token_supply, double quantity, const vector<LegacyBancorConverter::reserve_t>& reserves) {
+    check(!reserves.empty(), "converter has no reserves");
+    double total_weight = 0;
+    for (const LegacyBancorConverter::reserve_t& reserve : reserves)
+        total_weight += reserve.ratio / MAX_RATIO;
+    const double previous_weights = total_weight - reserves.back().ratio / MAX_RATIO;
+
+    // the share of each reserve left in the converter, such that the sales add up to `quantity` when the weights add up to less than 100%
+    double left_share = pow(1.0 - std::min(quantity / pool_token_supply, 1.0), 1.0 / total_weight);
+    if (left_share <= 0 && previous_weights > 0) // the entire supply is migrated, leave a single unit to be sold for the last reserve
+        left_share = pow(pool_token_supply, -1.0 / previous_weights);
+
+    vector<int64_t> liquidation_amounts;
+    double remaining_supply = pool_token_supply;
+    int64_t total_liquidated = 0;
+    for (size_t i = 0; i + 1 < reserves.size(); i++) {
+        const int64_t amount = remaining_supply * (1.0 - pow(left_share, reserves[i].ratio / MAX_RATIO));
+        liquidation_amounts.push_back(amount);
+        total_liquidated += amount;
+        remaining_supply -= amount;
+    }
+    liquidation_amounts.push_back(quantity - total_liquidated);
 
-    if (x1 > 1.0 && x1 <= quantity)
-        return x1 - 1.0;
-    else if (x2 > 1.0 && x2 <= quantity)
-        return x2 - 1.0;
-        
-    check(false, "couldn't find valid quadratic root. x1=" + to_string(x1) + " x2=" + to_string(x2) +", quantity: " + to_string(quantity));
-    return 0;
+    for (size_t i = 0; i < reserves.size(); i++)
+        check_format(liquidation_amounts[i] > 0, "pool token amount is too low to liquidate the {} reserve", reserves[i].currency.symbol);
+    return liquidation_amounts;
+}
+
+// returns the reserve tokens the old converter pays for the liquidation amounts, sold one after the other with the fee
+// disabled as in `liquidate_old_converter`, with the legacy converter's own conversion math,
+// each sale is priced with the supply left by the previous ones, as the converter reads it once they are retired
+vector<int64_t> BancorConverterMigration::calculate_liquidation_returns(const converter_t& converter, const LegacyBancorConverter::settings_t& settings, int64_t pool_token_supply,
+        const vector<LegacyBancorConverter::reserve_t>& reserves, const vector<int64_t>& liquidation_amounts) {
+    const uint8_t smart_precision = settings.smart_currency.symbol.precision();
+
+    // tokens the network deposited for a batch conversion are held by the converter, but are not part of its reserves
+    LegacyBancorConverter::deposits deposits_table(converter.account, converter.account.value);
+    vector<int64_t> returns;
+    for (size_t i = 0; i < reserves.size(); i++) {
+        const LegacyBancorConverter::reserve_t& reserve = reserves[i];
+        auto deposit = deposits_table.find(reserve.currency.symbol.code().raw());
+        const int64_t deposited = deposit == deposits_table.end() ? 0 : deposit->quantity.amount;
+        const int64_t balance = Token::get_balance(reserve.contract, converter.account, reserve.currency.symbol.code()).amount - deposited + reserve.currency.amount;
+        const conversion_return conversion = calculate_conversion_return(
+            { 0, smart_precision, 0, true, {} },
+            { balance, reserve.currency.symbol.precision(), reserve.ratio, false, reserve.curve.value_or(curve_coefficients{}) },
+            liquidation_amounts[i], amount_to_tokens(pool_token_supply, smart_precision), 0
+        );
+        returns.push_back(conversion.amount);
+        pool_token_supply -= liquidation_amounts[i];
+    }
+    return returns;
 }
 
 // inputReserve * supply / reserveBalance = amount
-double BancorConverterMigration::calculate_fund_pool_return(double funding_amount, double reserve_balance, double supply) {
-    return supply * funding_amount / reserve_balance;
+int64_t BancorConverterMigration::calculate_fund_pool_return(int64_t funding_amount, int64_t reserve_balance, int64_t supply) {
+    return mul_div(supply, funding_amount, reserve_balance);
 }
 
-// poolTokensToSell4ReserveA / _supply = (poolTokensSent - poolTokensToSell4ReserveA) / (_supply - poolTokensToSell4ReserveA)
+// each reserve is liquidated by selling pool tokens, one after the other, and must return the same share of its balance
+
+// selling x_k pool tokens for reserve k (weight F_k) against the supply left by the previous liquidations (_supply_k) returns
+// reserveBalance_k * (1 - (1 - x_k / _supply_k)^(1 / F_k)) = sharePerReserve * reserveBalance_k
 
-// (poolTokensToSell4ReserveA*_supply - poolTokensToSell4ReserveA^2) / (_supply^2 - 2*poolTokensToSell4ReserveA*_supply) = (poolTokensSent*_supply - poolTokensToSell4ReserveA*_supply) / (_supply^2 - 2*poolTokensToSell4ReserveA*_supply)
+// x_k = _supply_k * (1 - (1 - sharePerReserve)^F_k)
+// _supply_k = _supply * (1 - sharePerReserve)^(F_1 + ... + F_(k-1))
 
-// 2*poolTokensToSell4ReserveA*_supply - poolTokensToSell4ReserveA^2 - poolTokensSent*_supply =  0
+// the sales add up to poolTokensSent = _supply * (1 - (1 - sharePerReserve)^(F_1 + ... + F_N)), so
+// sharePerReserve = 1 - (1 - poolTokensSent / _supply)^(1 / (F_1 + ... + F_N)), which is poolTokensSent / _supply when the weights add up to 100%
 
-// poolTokensToSell4ReserveA^2 - 2*_supply*poolTokensToSell4ReserveA + poolTokensSent*_supply = 0
+// the last reserve is sold for whatever is left of poolTokensSent, which only differs from x_N by the rounding of the previous sales,
+// a single reserve is sold all of poolTokensSent, its whole balance when the entire supply is migrated
@@ -16,6 +16,27 @@
 using namespace eosio;
 using namespace std;
 
+/// the expected outcome of a migration, printed by `previewmig`
+#define EMIT_MIGRATION_PREVIEW_EVENT(old_pool_tokens, new_pool_token, converter_exists, reserve_previews, new_pool_tokens) { \
+    START_EVENT("migration_preview", "1.0") \
+    EVENTKV("old_pool_tokens", old_pool_tokens) \
+    EVENTKV("new_pool_token", new_pool_token) \
+    EVENTKV("converter_exists", converter_exists) \
+    print("\"reserves\":["); \
+    for (size_t i = 0; i < reserve_previews.size(); i++) { \
+        if (i != 0) print(","); \
+        print("{"); \
+        EVENTKV("contract", reserve_previews[i].contract) \
+        EVENTKV("symbol", reserve_previews[i].symbol) \
+        EVENTKV("liquidation_amount", reserve_previews[i].liquidation_amount) \
+        EVENTKVL("return", reserve_previews[i].return_amount) \
+        print("}"); \
+    } \
+    print("],"); \
+    EVENTKVL("new_pool_tokens", new_pool_tokens) \
+    END_EVENT() \
+}
+
 CONTRACT BancorConverterMigration : public contract {
     public:
         using contract::contract;
@@ -41,6 +62,13 @@ CONTRACT BancorConverterMigration : public contract {
             uint64_t primary_key() const { return "settings"_n.value; }
         };
         
+        // progress of a chunked migration, see `migstep`
+        struct migration_cursor {
+            uint16_t step;
+            uint32_t deadline; // in seconds since epoch, anyone may cancel the migration once it passes, pushed back by every step
+            vector<extended_symbol> reserves; // of the old converter when the migration started, the steps follow them
+        };
+
         TABLE migration_t {
             symbol old_pool_token;
             symbol_code new_pool_token;
@@ -48,64 +76,156 @@ CONTRACT BancorConverterMigration : public contract {
             uint8_t stage;
             name migration_initiator;
             bool converter_exists;
+            uint8_t reserves_count;
+            vector<extended_asset> liquidated_reserves;
+            binary_extension<migration_cursor> cursor; // only set on chunked migrations
             uint64_t primary_key() const { return old_pool_token.code().raw(); }
+            uint64_t by_new_pool_token() const { return new_pool_token.raw(); }
         };
         
         TABLE converter_t {
             symbol_code sym;
             name        account;
             name        owner;
+            binary_extension<symbol_code> new_pool_token; // computed on registration when the old converter has reserves, see `refreshsym`
+            binary_extension<uint8_t> reserves_count; // of the old converter, stored with the new pool token
             uint64_t primary_key() const { return sym.raw(); }
+            uint64_t by_account() const { return account.value; }
+            uint64_t by_owner() const { return owner.value; }
         };
 
-        TABLE reserve_balance_t {
-            extended_asset reserve;
-            uint64_t primary_key() const { return reserve.quantity.symbol.code().raw(); }
+        // a converter to register with `addconverters`, the new pool token of the registry row is computed by the contract
+        struct converter_entry {
+            symbol_code sym;
+            name        account;
+            name        owner;
         };
 
 
         typedef eosio::multi_index<"settings"_n, settings_t> settings_table;
-        typedef eosio::multi_index<"converters"_n, converter_t> converters;
+        typedef eosio::multi_index<"converters"_n, converter_t,
+                        indexed_by<"byaccount"_n, const_mem_fun<converter_t, uint64_t, &converter_t::by_account>>,
+                        indexed_by<"byowner"_n, const_mem_fun<converter_t, uint64_t, &converter_t::by_owner>>> converters;
         typedef eosio::singleton<"migrations"_n, migration_t> migrations;
         typedef eosio::multi_index<"migrations"_n, migration_t> dummy_for_abi;
-        typedef eosio::multi_index<"rsrvbalances"_n, reserve_balance_t> reserve_balances;
+        // chunked migrations between their steps, a row per old pool token
+        typedef eosio::multi_index<"chunkedmigs"_n, migration_t,
+                        indexed_by<"bynewtoken"_n, const_mem_fun<migration_t, uint64_t, &migration_t::by_new_pool_token>>> chunked_migrations;
 
 
         inline BancorConverterMigration(name receiver, name code, datastream<const char *> ds);
 
         ACTION setsettings(name bancor_converter, name multi_token, name network);
         ACTION addconverter(symbol_code converter_sym, name converter_account, name owner);
+        ACTION addconverters(const vector<converter_entry>& new_converters);
         ACTION delconverter(symbol_code converter_sym);
 
-        ACTION transferpool(name to, symbol_code pool_tokens);
-        ACTION refundrsrvs(symbol_code converter_pool_token);
+        /**
+         * @brief moves registry rows written under the former per-symbol scopes into the contract's own scope
+         * @details one-shot upgrade of an existing deployment, each row is registered again with `addconverter`'s checks and
+         * removed from its former scope, symbols without a row in their former scope are rejected
+         * @param converter_syms - old pool token symbols of the rows to move
+         */
+        ACTION rescope(const vector<symbol_code>& converter_syms);
+
+        /**
+         * @brief recomputes the new pool token a registered converter migrates to, and its reserves count, from its current reserves
+         * @details both are computed when the converter is registered, this updates them after the reserves of the
+         * old converter change, or stores them for converters registered before they had any reserve
+         * @param converter_sym - old pool token symbol of the registered converter
+         */
+        ACTION refreshsym(symbol_code converter_sym);
+
         ACTION fundexisting(symbol_code converter_currency_sym);
         ACTION fundnew(symbol_code converter_currency_sym);
+        ACTION finalize(symbol_code converter_sym);
         ACTION assertsucess(symbol_code converter_sym);
+
+        /**
+         * @brief runs the next step of a chunked migration, started by sending the pool tokens with a "chunked" memo
+         * @details each step sends a bounded number of actions: the creation of the new converter, then one of its reserves at a time
+         * when it does not exist yet, and finally the liquidation of every reserve and the funding of the new converter, in a single step
+         * so that the reserves are sold at the same prices, must be signed by the migration initiator.
+         * The last step is not split by reserve: sales in separate transactions could be traded against in between, and the new
+         * converter is only funded once every reserve is sold, so it costs as much as the liquidation of a single transaction migration.
+         * The steps are rejected once the reserves of the old converter differ from those it had when the migration started,
+         * the migration can then only be cancelled. Chunked migrations of other converters may run at the same time
+         * @param converter_sym - old pool token symbol of the migration in progress
+         */
+        ACTION migstep(symbol_code converter_sym);
+
+        /**
+         * @brief cancels a chunked migration before its last step, and refunds the old pool tokens to the migration initiator
+         * @details must be signed by the migration initiator, the converter owner or the contract, or by anyone once the migration
+         * was not advanced before its deadline. A new converter created by the migration is handed over to the converter owner,
+         * who authorized its creation, with the pool tokens it was created with
+         * @param converter_sym - old pool token symbol of the migration in progress
+         */
+        ACTION cancelmig(symbol_code converter_sym);
+
+        /**
+         * @brief prints the expected outcome of migrating `quantity` old pool tokens in a migration_preview event
+         * @details computed from the current tables with the migration's own math, the old pool tokens sold for each reserve,
+         * the reserve tokens they return without the fee, and the new pool tokens of the new or existing converter,
+         * does not modify any table nor send any action
+         * @param quantity - old pool tokens to migrate
+         */
+        ACTION previewmig(asset quantity);
         
         [[eosio::on_notify("*::transfer")]]
         void on_transfer(name from, name to, asset quantity, string memo);
     private:
+        struct reserve_preview {
+            name contract;
+            symbol_code symbol;
+            double liquidation_amount;
+            double return_amount;
+        };
+
         settings_table st;
         settings_table::const_iterator p_global_settings;
 
+        void add_converter(converters& converters_table, symbol_code converter_sym, name converter_account, name owner);
         void create_converter(name from, asset quantity, const symbol_code& new_pool_token);
+        void create_new_converter(asset quantity, const symbol_code& new_pool_token, uint64_t fee);
+        void set_new_converter_reserve(const symbol_code& new_pool_token, const LegacyBancorConverter::reserve_t& reserve);
         void liquidate_old_converter(symbol_code converter_currency_sym);
+        void liquidate_reserve(const converter_t& converter, const LegacyBancorConverter::settings_t& settings, const LegacyBancorConverter::reserve_t& reserve, int64_t amount);
+        void update_original_fee(const converter_t& converter, const LegacyBancorConverter::settings_t& settings, uint64_t fee);
+        void fund_new_converter(const migration_t& migration);
         void handle_liquidated_reserve(name from, asset quantity);
         
         void init_migration(name from, asset quantity, bool converter_exists, const symbol_code& new_pool_token);
+        void park_migration(name from, asset quantity, bool converter_exists, const symbol_code& new_pool_token);
+        migration_t make_migration(name from, asset quantity, bool converter_exists, const symbol_code& new_pool_token);
+        void check_no_chunked_migration(symbol_code converter_sym, symbol_code new_pool_token);
+        void check_unchanged_reserves(const migration_cursor& cursor, const vector<LegacyBancorConverter::reserve_t>& reserves);
         void increment_converter_stage(symbol_code converter_currency);
-        void clear(symbol_code converter_currency);
+        void transfer_pool_tokens(const migration_t& migration);
+        void refund_reserves(const migration_t& migration);
+        void assert_success(symbol_code converter_sym);
+        void assert_migration_balances(const converter_t& converter, const migration_t& migration);
         vector<LegacyBancorConverter::reserve_t> get_original_reserves(converter_t converter);
+        uint8_t count_original_reserves(name converter_account);
+        uint8_t get_reserves_count(const converter_t& converter);
         const BancorConverter::reserve_t& get_new_converter_reserve(symbol_code converter_sym, symbol_code reserve_sym);
         const LegacyBancorConverter::settings_t& get_original_converter_settings(converter_t converter);
         const converter_t& get_converter(symbol_code sym);
-        const symbol_code generate_converter_symbol(symbol_code old_sym);
+        void check_single_pool(name converter_account);
+        void check_single_pool(const converter_t& converter);
+        const symbol_code get_new_pool_token(const converter_t& converter);
+        const symbol_code generate_converter_symbol(name converter_account);
         bool does_converter_exist(symbol_code sym);
         
-        double calculate_first_reserve_liquidation_amount(double pool_token_supply, double quantity);
-        double calculate_fund_pool_return(double funding_amount, double reserve_balance, double supply);
+        int64_t get_original_supply(const LegacyBancorConverter::settings_t& settings);
+        int64_t get_funding_pool_return(symbol_code new_pool_token, const vector<extended_asset>& reserves);
+
+        vector<int64_t> calculate_liquidation_amounts(double pool_token_supply, double quantity, const vector<LegacyBancorConverter::reserve_t>& reserves);
+        vector<int64_t> calculate_liquidation_returns(const converter_t& converter, const LegacyBancorConverter::settings_t& settings, int64_t pool_token_supply,
+            const vector<LegacyBancorConverter::reserve_t>& reserves, const vector<int64_t>& liquidation_amounts);
+        int64_t calculate_fund_pool_return(int64_t funding_amount, int64_t reserve_balance, int64_t supply);
         
         const symbol_code NETWORK_TOKEN_CODE = symbol_code("BNT");
         const double MAX_RATIO = 1000000.0;
+        const uint32_t CHUNKED_MIGRATION_TIMEOUT = 24 * 60 * 60; // seconds
 };
@@ -8,17 +8,28 @@
 #include "../includes/Token.hpp"
 #include "LegacyBancorConverter.hpp"
 
-ACTION LegacyBancorConverter::init(name smart_contract, asset smart_currency, bool smart_enabled, bool enabled, name network, bool require_balance, uint64_t max_fee, uint64_t fee) {
+ACTION LegacyBancorConverter::init(name smart_contract, asset smart_currency, bool smart_enabled, bool enabled, name network, bool require_balance, uint64_t max_fee, uint64_t fee, binary_extension<symbol_code> pool) {
     require_auth(get_self());
-    check(max_fee <= MAX_FEE,
-         ("maximum fee must be lower or equal to " + std::to_string(MAX_FEE)).c_str()
-    ); 
+    check_format(max_fee <= MAX_FEE, "maximum fee must be lower or equal to {}", MAX_FEE);
     check(fee <= max_fee, "fee must be lower or equal to the maximum fee");
 
-    settings settings_table(get_self(), get_self().value);
+    pools pools_table(get_self(), get_self().value);
+    if (pool.has_value()) {
+        check(pool.value() == smart_currency.symbol.code(), "pool must be the smart currency symbol");
+        settings single_pool_settings(get_self(), get_self().value);
+        check(single_pool_settings.find("settings"_n.value) == single_pool_settings.end(), "account already holds a single pool");
+    }
+    else check(pools_table.begin() == pools_table.end(), "account already hosts pools");
+
+    settings settings_table(get_self(), pool_scope(pool.value_or()));
     auto st = settings_table.find("settings"_n.value);
     check(st == settings_table.end(), "settings already exist");
     check(is_account(smart_contract), "invalid relay token account");
+    if (pool.has_value())
+        pools_table.emplace(get_self(), [&](auto& p) {
+            p.pool = pool.value();
+            p.network = network;
+        });
     
     st = settings_table.emplace(get_self(), [&](auto& s) {		
         s.smart_contract  = smart_contract;
@@ -32,10 +43,10 @@ ACTION LegacyBancorConverter::init(name smart_contract, asset smart_currency, bo
     });
 }
 
-ACTION LegacyBancorConverter::update(bool smart_enabled, bool enabled, bool require_balance, uint64_t fee) {
+ACTION LegacyBancorConverter::update(bool smart_enabled, bool enabled, bool require_balance, uint64_t fee, binary_extension<symbol_code> pool) {
     require_auth(get_self());
     
-    settings settings_table(get_self(), get_self().value);
+    settings settings_table(get_self(), pool_scope(pool.value_or()));
     const auto& st = settings_table.get("settings"_n.value, "settings do not exist");
     
     check(fee <= st.max_fee, "fee must be lower or equal to the maximum fee");
@@ -51,14 +62,49 @@ ACTION LegacyBancorConverter::update(bool smart_enabled, bool enabled, bool requ
         EMIT_CONVERSION_FEE_UPDATE_EVENT(prevFee, fee);
 }
 
-ACTION LegacyBancorConverter::setreserve(name contract, symbol currency, uint64_t ratio, bool sale_enabled) {
+ACTION LegacyBancorConverter::setpoolevent(bool enabled, binary_extension<symbol_code> pool) {
+    require_auth(get_self());
+
+    settings settings_table(get_self(), pool_scope(pool.value_or()));
+    const auto& st = settings_table.get("settings"_n.value, "settings do not exist");
+
+    settings_table.modify(st, get_self(), [&](auto& s) {
+        s.pool_state_event.emplace(enabled);
+    });
+}
+
+ACTION LegacyBancorConverter::setretire(int64_t threshold, binary_extension<symbol_code> pool) {
+    require_auth(get_self());
+    check(threshold >= 0, "threshold must be positive or 0");
+
+    settings settings_table(get_self(), pool_scope(pool.value_or()));
+    const auto& st = settings_table.get("settings"_n.value, "settings do not exist");
+
+    settings_table.modify(st, get_self(), [&](auto& s) {
+        s.pool_state_event.emplace(s.pool_state_event.value_or(false)); // the extensions before the threshold must be present
+        s.retire_threshold.emplace(threshold);
+        s.pending_retire.emplace(s.pending_retire.value_or(0));
+    });
+    if (threshold == 0)
+        retire_smart(settings_table, st, 0, true);
+}
+
+ACTION LegacyBancorConverter::retirepend(binary_extension<symbol_code> pool) {
+    settings settings_table(get_self(), pool_scope(pool.value_or()));
+    const auto& st = settings_table.get("settings"_n.value, "settings do not exist");
+    check(st.pending_retire.value_or(0) > 0, "no pending pool tokens to retire");
+
+    retire_smart(settings_table, st, 0, true);
+}
+
+ACTION LegacyBancorConverter::setreserve(name contract, symbol currency, uint64_t ratio, bool sale_enabled, binary_extension<symbol_code> pool) {
     require_auth(get_self());
     check(currency.is_valid(), "invalid symbol");
     check(is_account(contract), "token's contract is not an account");
-    check(ratio > 0 && ratio <= MAX_RATIO,
-         ("ratio must be between 1 and " + std::to_string(MAX_RATIO)).c_str());
+    check_format(ratio > 0 && ratio <= MAX_RATIO, "ratio must be between 1 and {}", MAX_RATIO);
 
-    reserves reserves_table(get_self(), get_self().value);
+    const symbol_code pool_code = pool.value_or();
+    reserves reserves_table(get_self(), pool_scope(pool_code));
     auto existing = reserves_table.find(currency.code().raw());
     if (existing != reserves_table.end()) {
         check(existing->contract == contract, "cannot update the reserve contract name");
@@ -66,6 +112,7 @@ ACTION LegacyBancorConverter::setreserve(name contract, symbol currency, uint64_
         reserves_table.modify(existing, get_self(), [&](auto& s) {
             s.ratio = ratio;
             s.sale_enabled = sale_enabled;
+            s.curve.emplace(make_curve_coefficients(ratio));
         });
     }
     else reserves_table.emplace(get_self(), [&](auto& s) {
@@ -73,49 +120,62 @@ ACTION LegacyBancorConverter::setreserve(name contract, symbol currency, uint64_
         s.currency  = asset(0, currency);
         s.ratio     = ratio;
         s.sale_enabled = sale_enabled;
+        s.curve.emplace(make_curve_coefficients(ratio));
+        if (pool_code.raw())
+            s.balance.emplace(0);
     });
     uint64_t total_ratio = 0;
     for (auto& reserve : reserves_table)
         total_ratio += reserve.ratio;
     
-    check(total_ratio <= MAX_RATIO, 
-         ("ratio must be between 1 and " + std::to_string(MAX_RATIO)).c_str());
+    check_format(total_ratio <= MAX_RATIO, "total ratio must be between 1 and {}, got {}", MAX_RATIO, total_ratio);
 
-    settings settings_table(get_self(), get_self().value);
+    settings settings_table(get_self(), pool_scope(pool_code));
     const auto& converter_settings = settings_table.get("settings"_n.value, "settings do not exist");
 
-    auto current_smart_supply = (get_supply(converter_settings.smart_contract, converter_settings.smart_currency.symbol.code())).amount + converter_settings.smart_currency.amount;
-    current_smart_supply /= pow(10, converter_settings.smart_currency.symbol.precision());
-    auto reserve_balance = get_balance_amount(contract, get_self(), currency.code()) / pow(10, currency.precision()); 
+    auto current_smart_supply = get_smart_supply(converter_settings);
+    auto reserve_balance = amount_to_tokens(get_reserve_balance(reserves_table.get(currency.code().raw()), pool_code), currency.precision());
+    update_price(currency.code(), reserve_balance / (ratio / MAX_RATIO), pool_code);
+    if (is_pool_state_event_enabled(converter_settings)) {
+        emit_pool_state(current_smart_supply, {}, pool_code);
+        return;
+    }
     EMIT_PRICE_DATA_EVENT(current_smart_supply, contract, currency.code(), reserve_balance, ratio / MAX_RATIO);
 }
 
-ACTION LegacyBancorConverter::delreserve(symbol_code currency) {
+ACTION LegacyBancorConverter::delreserve(symbol_code currency, binary_extension<symbol_code> pool) {
     require_auth(get_self());
     check(currency.is_valid(), "invalid symbol");
 
-    reserves reserves_table(get_self(), get_self().value);
+    reserves reserves_table(get_self(), pool_scope(pool.value_or()));
     const auto& rsrv = reserves_table.get(currency.raw(), "reserve not found");
     
-    asset balance = get_balance(rsrv.contract, get_self(), currency);
-    check(!balance.amount, "may delete only empty reserves");
+    int64_t balance = pool.has_value() ? rsrv.balance.value_or(0) : get_balance(rsrv.contract, get_self(), currency).amount;
+    check(!balance, "may delete only empty reserves");
 
     reserves_table.erase(rsrv);
 }
 
 void LegacyBancorConverter::convert(name from, eosio::asset quantity, std::string memo, name code) {
-    auto from_amount = quantity.amount / pow(10, quantity.symbol.precision());
+    auto from_amount = amount_to_tokens(quantity.amount, quantity.symbol.precision());
 
     auto memo_object = parse_memo(memo);
+    if (memo_object.route_id) { // conversions are only accepted from the network, which holds the routes
+        check(is_network(from), "converter can only receive from network contract");
+        routes routes_table(from, from.value);
+        resolve_route(memo_object, routes_table.get(memo_object.route_id, "route not found"));
+    }
     check(memo_object.path.size() > 1, "invalid memo format");
+
+    auto contract_name = memo_object.converters[0].account;
+    const symbol_code pool = memo_object.converters[0].sym.empty() ? symbol_code() : symbol_code(memo_object.converters[0].sym);
     
-    settings settings_table(get_self(), get_self().value);
+    settings settings_table(get_self(), pool_scope(pool));
     const auto& converter_settings = settings_table.get("settings"_n.value, "settings do not exist");
     
     check(converter_settings.enabled, "converter is disabled");
     check(converter_settings.network == from, "converter can only receive from network contract");
 
-    auto contract_name = name(memo_object.path[0].c_str());
     auto from_path_currency = quantity.symbol.code().raw();
     auto to_path_currency = symbol_code(memo_object.path[1].c_str()).raw();
 
@@ -123,8 +183,8 @@ void LegacyBancorConverter::convert(name from, eosio::asset quantity, std::strin
     check(from_path_currency != to_path_currency, "cannot convert to self");
     
     auto smart_symbol_name = converter_settings.smart_currency.symbol.code().raw();
-    auto from_token = get_reserve(from_path_currency, converter_settings);
-    auto to_token = get_reserve(to_path_currency, converter_settings);
+    auto from_token = get_reserve(from_path_currency, converter_settings, pool);
+    auto to_token = get_reserve(to_path_currency, converter_settings, pool);
 
     auto from_currency = from_token.currency;
     auto to_currency = to_token.currency;
@@ -141,65 +201,68 @@ void LegacyBancorConverter::convert(name from, eosio::asset quantity, std::strin
     auto to_ratio = to_token.ratio;
 
     check(to_token.sale_enabled, "'to' token purchases disabled");
-    check(code == from_contract, "unknown 'from' contract");
-    
-    auto current_from_balance = ((get_balance(from_contract, get_self(), from_currency.symbol.code())).amount + from_currency.amount - quantity.amount) / pow(10, from_currency.symbol.precision()); 
-    auto current_to_balance = ((get_balance(to_contract, get_self(), to_currency.symbol.code())).amount + to_currency.amount) / pow(10, to_currency_precision);
+    check_format(code == from_contract, "unknown 'from' contract {}, expected {}", code, from_contract);
     
-    double current_smart_supply = (get_supply(converter_settings.smart_contract, converter_settings.smart_currency.symbol.code())).amount + converter_settings.smart_currency.amount;
-    current_smart_supply /= pow(10, converter_settings.smart_currency.symbol.precision());
-
-    name final_to = name(memo_object.dest_account.c_str());
-    
-    double smart_tokens = 0;
-    double to_tokens = 0;
-    bool quick = false;
-    
-    if (incoming_smart_token) {
-        action( // destory received token
-            permission_level{ get_self(), "active"_n },
-            converter_settings.smart_contract, "retire"_n,
-            std::make_tuple(quantity, string("destroy on conversion"))
-        ).send();
-
-        smart_tokens = from_amount;
-    }
-    else if (!incoming_smart_token && !outgoing_smart_token && (from_ratio == to_ratio)) {
-        to_tokens = quick_convert(current_from_balance, from_amount, current_to_balance);
-        quick = true;
-    }
-    else {
-        smart_tokens = calculate_purchase_return(current_from_balance, from_amount, current_smart_supply, from_ratio);
-        current_smart_supply += smart_tokens;
-    }
-    auto issue = false;
-
-    if (outgoing_smart_token) {
+    if (outgoing_smart_token)
         check(memo_object.path.size() == 2, "smart token must be final currency");
-        to_tokens = smart_tokens;
-        issue = true;
-    }
-    else if (!quick) {
-        to_tokens = calculate_sale_return(current_to_balance, smart_tokens, current_smart_supply, to_ratio);
-        current_smart_supply -= smart_tokens;
+
+    // external state is only read where the formula or the events need it:
+    // the smart token side has no balance, and conversions between reserves leave the supply as is
+    // the account's token balance already includes the received quantity, a tracked pool balance does not
+    int64_t current_from_balance_amount = incoming_smart_token ? 0 : get_reserve_balance(from_token, pool) - (pool.raw() ? 0 : quantity.amount);
+    int64_t current_to_balance_amount = outgoing_smart_token ? 0 : get_reserve_balance(to_token, pool);
+    auto current_from_balance = amount_to_tokens(current_from_balance_amount, from_currency.symbol.precision());
+    auto current_to_balance = amount_to_tokens(current_to_balance_amount, to_currency_precision);
+
+    const bool supply_conversion = incoming_smart_token || outgoing_smart_token;
+    double current_smart_supply = supply_conversion ? get_smart_supply(converter_settings) : 0;
+
+    const conversion_return conversion = calculate_conversion_return(
+        { current_from_balance_amount, from_currency.symbol.precision(), from_ratio, incoming_smart_token, from_token.curve.value_or(curve_coefficients{}) },
+        { current_to_balance_amount, to_currency_precision, to_ratio, outgoing_smart_token, to_token.curve.value_or(curve_coefficients{}) },
+        quantity.amount, current_smart_supply, converter_settings.fee
+    );
+    int64_t to_amount = conversion.amount;
+    int64_t fee_amount = conversion.fee;
+    current_smart_supply = supply_conversion ? conversion.smart_supply : get_smart_supply(converter_settings); // for the price events
+    auto issue = outgoing_smart_token;
+
+    check(to_amount > 0, "below min return");
+    if (memo_object.path.size() == 2) { // last conversion in the path, the return is in the final currency
+        int64_t min_return = to_scaled_amount(memo_object.min_return, to_currency_precision);
+        check_format(to_amount >= min_return, "below min return, return is {} and min return is {} {} units", to_amount, min_return, to_currency.symbol);
     }
-    uint8_t magnitude = (incoming_smart_token || outgoing_smart_token) ? 1 : 2;
-    double fee = calculate_fee(to_tokens, converter_settings.fee, magnitude);
-    to_tokens -= fee;
 
-    if (outgoing_smart_token)
-        current_smart_supply -= fee;
-    
-    double formatted_total_fee_amount = to_fixed(fee, to_currency_precision);
-    
-    to_tokens = to_fixed(to_tokens, to_currency_precision);
+    double formatted_total_fee_amount = amount_to_tokens(fee_amount, to_currency_precision);
+    double to_tokens = amount_to_tokens(to_amount, to_currency_precision);
 
     EMIT_CONVERSION_EVENT(memo, from_token.contract, from_currency.symbol.code(), to_token.contract, to_currency.symbol.code(), from_amount, to_tokens, formatted_total_fee_amount);
 
-    if (!incoming_smart_token)
-        EMIT_PRICE_DATA_EVENT(current_smart_supply, from_token.contract, from_currency.symbol.code(), current_from_balance + from_amount, from_ratio / MAX_RATIO);
-    if (!outgoing_smart_token)
-        EMIT_PRICE_DATA_EVENT(current_smart_supply, to_token.contract, to_currency.symbol.code(), current_to_balance - to_tokens, to_ratio / MAX_RATIO);
+    if (!incoming_smart_token) {
+        add_reserve_balance(from_currency.symbol.code(), quantity.amount, pool);
+        update_price(from_currency.symbol.code(), (current_from_balance + from_amount) / (from_ratio / MAX_RATIO), pool);
+    }
+    if (!outgoing_smart_token) {
+        add_reserve_balance(to_currency.symbol.code(), -to_amount, pool);
+        update_price(to_currency.symbol.code(), (current_to_balance - to_tokens) / (to_ratio / MAX_RATIO), pool);
+    }
+    if (supply_conversion)
+        update_price(converter_settings.smart_currency.symbol.code(), current_smart_supply, pool);
+
+    if (is_pool_state_event_enabled(converter_settings)) {
+        vector<reserve_state> updated_states;
+        if (!incoming_smart_token)
+            updated_states.push_back({ from_token.contract, from_currency.symbol.code(), current_from_balance + from_amount, from_ratio / MAX_RATIO });
+        if (!outgoing_smart_token)
+            updated_states.push_back({ to_token.contract, to_currency.symbol.code(), current_to_balance - to_tokens, to_ratio / MAX_RATIO });
+        emit_pool_state(current_smart_supply, updated_states, pool);
+    }
+    else {
+        if (!incoming_smart_token)
+            EMIT_PRICE_DATA_EVENT(current_smart_supply, from_token.contract, from_currency.symbol.code(), current_from_balance + from_amount, from_ratio / MAX_RATIO);
+        if (!outgoing_smart_token)
+            EMIT_PRICE_DATA_EVENT(current_smart_supply, to_token.contract, to_currency.symbol.code(), current_to_balance - to_tokens, to_ratio / MAX_RATIO);
+    }
 
     path new_path = memo_object.path;
     new_path.erase(new_path.begin(), new_path.begin() + 2);
@@ -207,18 +270,19 @@ void LegacyBancorConverter::convert(name from, eosio::asset quantity, std::strin
 
     auto new_memo = build_memo(memo_object);
 
-    uint64_t to_amount = to_tokens * pow(10, to_currency_precision);
     asset new_asset = asset(to_amount, to_currency.symbol);
     name inner_to = converter_settings.network;
 
+    if (incoming_smart_token) // destory received token
+        retire_smart(settings_table, converter_settings, quantity.amount, false);
+
     if (issue)
         action(
             permission_level{ get_self(), "active"_n },
             to_contract, "issue"_n,
             make_tuple(get_self(), new_asset, new_memo) 
         ).send();
-    
-    check(new_asset.amount > 0, "below min return");
+
     action(
         permission_level{ get_self(), "active"_n },
         to_contract, "transfer"_n,
@@ -226,9 +290,145 @@ void LegacyBancorConverter::convert(name from, eosio::asset quantity, std::strin
     ).send();
 }
 
+ACTION LegacyBancorConverter::convertbatch(const vector<batch_conversion>& conversions, binary_extension<symbol_code> pool) {
+    const symbol_code pool_code = pool.value_or();
+    settings settings_table(get_self(), pool_scope(pool_code));
+    const auto& converter_settings = settings_table.get("settings"_n.value, "settings do not exist");
+
+    require_auth(converter_settings.network);
+    check(converter_settings.enabled, "converter is disabled");
+    check(!conversions.empty(), "empty batch");
+
+    const symbol smart_symbol = converter_settings.smart_currency.symbol;
+    int64_t smart_supply = get_supply(converter_settings.smart_contract, smart_symbol.code()).amount + converter_settings.smart_currency.amount;
+    int64_t smart_in = 0;
+    int64_t smart_out = 0;
+
+    vector<batch_reserve> batch;
+    vector<tuple<name, size_t, int64_t>> payouts; // recipient, index of the reserve in the batch, amount
+    for (const batch_conversion& conversion : conversions) {
+        const size_t from_index = get_batch_reserve(batch, conversion.quantity.symbol.code(), converter_settings, pool_code);
+        const size_t to_index = get_batch_reserve(batch, conversion.min_return.symbol.code(), converter_settings, pool_code);
+        batch_reserve& from = batch[from_index];
+        batch_reserve& to = batch[to_index];
+
+        check(from_index != to_index, "cannot convert to self");
+        check(to.reserve.sale_enabled, "'to' token purchases disabled");
+        check_format(conversion.quantity.symbol == from.reserve.currency.symbol && conversion.quantity.amount > 0, "invalid quantity {}", conversion.quantity);
+        check_format(conversion.min_return.symbol == to.reserve.currency.symbol, "invalid min return {}", conversion.min_return);
+        check_format(conversion.quantity.amount <= from.deposited, "{} was not deposited", conversion.quantity);
+
+        const uint8_t from_precision = from.reserve.currency.symbol.precision();
+        const uint8_t to_precision = to.reserve.currency.symbol.precision();
+        const conversion_return result = calculate_conversion_return(
+            { from.balance, from_precision, from.reserve.ratio, from.smart, from.reserve.curve.value_or(curve_coefficients{}) },
+            { to.balance, to_precision, to.reserve.ratio, to.smart, to.reserve.curve.value_or(curve_coefficients{}) },
+            conversion.quantity.amount, amount_to_tokens(smart_supply, smart_symbol.precision()), converter_settings.fee
+        );
+        check(result.amount > 0, "below min return");
+        check_format(result.amount >= conversion.min_return.amount, "below min return, return is {} and min return is {}", asset(result.amount, to.reserve.currency.symbol), conversion.min_return);
+
+        from.deposited -= conversion.quantity.amount;
+        if (from.smart) {
+            smart_supply -= conversion.quantity.amount;
+            smart_in += conversion.quantity.amount;
+        }
+        else from.balance += conversion.quantity.amount;
+
+        if (to.smart) {
+            smart_supply += result.amount;
+            smart_out += result.amount;
+        }
+        else to.balance -= result.amount;
+
+        auto payout = std::find_if(payouts.begin(), payouts.end(), [&](const auto& p) {
+            return get<0>(p) == conversion.recipient && get<1>(p) == to_index;
+        });
+        if (payout == payouts.end())
+            payouts.push_back({ conversion.recipient, to_index, result.amount });
+        else
+            get<2>(*payout) += result.amount;
+
+        EMIT_CONVERSION_EVENT(conversion.memo, from.reserve.contract, from.reserve.currency.symbol.code(), to.reserve.contract, to.reserve.currency.symbol.code(),
+            amount_to_tokens(conversion.quantity.amount, from_precision), amount_to_tokens(result.amount, to_precision), amount_to_tokens(result.fee, to_precision));
+    }
+
+    deposits deposits_table(get_self(), pool_scope(pool_code));
+    vector<reserve_state> updated_states;
+    const double smart_supply_tokens = amount_to_tokens(smart_supply, smart_symbol.precision());
+    for (const batch_reserve& reserve : batch) {
+        auto deposit = deposits_table.find(reserve.reserve.currency.symbol.code().raw());
+        if (deposit != deposits_table.end() && reserve.deposited == 0)
+            deposits_table.erase(deposit);
+        else if (deposit != deposits_table.end() && reserve.deposited != deposit->quantity.amount)
+            deposits_table.modify(deposit, same_payer, [&](auto& d) {
+                d.quantity.amount = reserve.deposited;
+            });
+
+        if (reserve.smart)
+            continue;
+        const double balance = amount_to_tokens(reserve.balance, reserve.reserve.currency.symbol.precision());
+        add_reserve_balance(reserve.reserve.currency.symbol.code(), reserve.balance - reserve.initial_balance, pool_code);
+        if (reserve.balance != reserve.initial_balance)
+            update_price(reserve.reserve.currency.symbol.code(), balance / (reserve.reserve.ratio / MAX_RATIO), pool_code);
+        updated_states.push_back({ reserve.reserve.contract, reserve.reserve.currency.symbol.code(), balance, reserve.reserve.ratio / MAX_RATIO });
+    }
+    if (smart_in != smart_out)
+        update_price(smart_symbol.code(), smart_supply_tokens, pool_code);
+
+    if (is_pool_state_event_enabled(converter_settings))
+        emit_pool_state(smart_supply_tokens, updated_states, pool_code);
+    else for (const reserve_state& state : updated_states)
+        EMIT_PRICE_DATA_EVENT(smart_supply_tokens, state.contract, state.symbol, state.balance, state.ratio);
+
+    // pool tokens converted from pay for the ones converted to, only the difference is retired or issued
+    if (smart_in > smart_out)
+        retire_smart(settings_table, converter_settings, smart_in - smart_out, false);
+    else if (smart_out > smart_in)
+        action(
+            permission_level{ get_self(), "active"_n },
+            converter_settings.smart_contract, "issue"_n,
+            make_tuple(get_self(), asset(smart_out - smart_in, smart_symbol), string("batch conversion"))
+        ).send();
+
+    for (const auto& [recipient, index, amount] : payouts)
+        action(
+            permission_level{ get_self(), "active"_n },
+            batch[index].reserve.contract, "transfer"_n,
+            make_tuple(get_self(), recipient, asset(amount, batch[index].reserve.currency.symbol), string("batch conversion"))
+        ).send();
+}
+
+ACTION LegacyBancorConverter::refund(name recipient, asset quantity, binary_extension<symbol_code> pool) {
+    const symbol_code pool_code = pool.value_or();
+    settings settings_table(get_self(), pool_scope(pool_code));
+    const auto& converter_settings = settings_table.get("settings"_n.value, "settings do not exist");
+
+    require_auth(converter_settings.network);
+    check(is_account(recipient), "recipient account does not exist");
+    check(quantity.is_valid() && quantity.amount > 0, "invalid quantity");
+
+    deposits deposits_table(get_self(), pool_scope(pool_code));
+    const auto& deposit = deposits_table.get(quantity.symbol.code().raw(), "no deposit found");
+    check(deposit.quantity.symbol == quantity.symbol, "invalid deposit symbol");
+    check(deposit.quantity.amount >= quantity.amount, "quantity exceeds the deposit");
+    if (deposit.quantity.amount == quantity.amount)
+        deposits_table.erase(deposit);
+    else deposits_table.modify(deposit, same_payer, [&](auto& d) {
+        d.quantity -= quantity;
+    });
+
+    const auto& reserve = get_reserve(quantity.symbol.code().raw(), converter_settings, pool_code);
+    action(
+        permission_level{ get_self(), "active"_n },
+        reserve.contract, "transfer"_n,
+        make_tuple(get_self(), recipient, quantity, string("deposit refund"))
+    ).send();
+}
+
 // returns a reserve object
 // can also be called for the smart token itself
-const LegacyBancorConverter::reserve_t& LegacyBancorConverter::get_reserve(uint64_t name, const settings_t& settings) {
+const LegacyBancorConverter::reserve_t& LegacyBancorConverter::get_reserve(uint64_t name, const settings_t& settings, symbol_code pool) {
     if (settings.smart_currency.symbol.code().raw() == name) {
         static reserve_t temp_reserve;
         temp_reserve.ratio = 0;
@@ -237,12 +437,188 @@ const LegacyBancorConverter::reserve_t& LegacyBancorConverter::get_reserve(uint6
         temp_reserve.sale_enabled = settings.smart_enabled;
         return temp_reserve;
     }
-    reserves reserves_table(get_self(), get_self().value);
+    reserves reserves_table(get_self(), pool_scope(pool));
     auto existing = reserves_table.find(name);
-    check(existing != reserves_table.end(), "reserve not found");
+    check_format(existing != reserves_table.end(), "reserve {} not found", symbol_code(name));
     return *existing;
 }
 
+// adds tokens sent with a "setup:<pool>" memo to the reserve of a pool hosted with other pools
+void LegacyBancorConverter::fund(asset quantity, name code, symbol_code pool) {
+    settings settings_table(get_self(), pool_scope(pool));
+    const auto& converter_settings = settings_table.get("settings"_n.value, "settings do not exist");
+    check(quantity.symbol.code() != converter_settings.smart_currency.symbol.code(), "cannot fund the smart token");
+
+    const auto& reserve = get_reserve(quantity.symbol.code().raw(), converter_settings, pool);
+    check_format(code == reserve.contract, "unknown 'from' contract {}, expected {}", code, reserve.contract);
+    check(quantity.symbol == reserve.currency.symbol, "invalid reserve symbol");
+    add_reserve_balance(quantity.symbol.code(), quantity.amount, pool);
+}
+
+// records tokens sent by the network for a following batch conversion
+void LegacyBancorConverter::deposit(name from, asset quantity, name code, symbol_code pool) {
+    settings settings_table(get_self(), pool_scope(pool));
+    const auto& converter_settings = settings_table.get("settings"_n.value, "settings do not exist");
+    check(converter_settings.network == from, "converter can only receive from network contract");
+
+    const auto& reserve = get_reserve(quantity.symbol.code().raw(), converter_settings, pool);
+    check_format(code == reserve.contract, "unknown 'from' contract {}, expected {}", code, reserve.contract);
+    check(quantity.symbol == reserve.currency.symbol, "invalid deposit symbol");
+
+    deposits deposits_table(get_self(), pool_scope(pool));
+    auto existing = deposits_table.find(quantity.symbol.code().raw());
+    if (existing == deposits_table.end())
+        deposits_table.emplace(get_self(), [&](auto& d) {
+            d.quantity = quantity;
+        });
+    else deposits_table.modify(existing, same_payer, [&](auto& d) {
+        d.quantity += quantity;
+    });
+}
+
+// returns the index of a reserve in the batch, reading its balance and deposits the first time it is converted from or to
+size_t LegacyBancorConverter::get_batch_reserve(vector<batch_reserve>& batch, symbol_code sym, const settings_t& settings, symbol_code pool) {
+    for (size_t i = 0; i < batch.size(); i++)
+        if (batch[i].reserve.currency.symbol.code() == sym)
+            return i;
+
+    const reserve_t& reserve = get_reserve(sym.raw(), settings, pool);
+    const bool smart = sym == settings.smart_currency.symbol.code();
+
+    deposits deposits_table(get_self(), pool_scope(pool));
+    auto deposit = deposits_table.find(sym.raw());
+    const int64_t deposited = deposit == deposits_table.end() ? 0 : deposit->quantity.amount;
+    const int64_t balance = smart ? 0 : get_reserve_balance(reserve, pool);
+
+    batch.push_back({ reserve, smart, balance, balance, deposited });
+    return batch.size() - 1;
+}
+
+// retires pool tokens converted from, or adds them to the pending ones until they reach the retire threshold,
+// `flush` retires the pending ones regardless of the threshold
+void LegacyBancorConverter::retire_smart(settings& settings_table, const settings_t& settings, int64_t amount, bool flush) {
+    const int64_t pending = settings.pending_retire.value_or(0);
+    if (!flush && pending + amount < settings.retire_threshold.value_or(0)) {
+        settings_table.modify(settings, same_payer, [&](auto& s) {
+            s.smart_currency.amount -= amount;
+            s.pending_retire.emplace(pending + amount);
+        });
+        return;
+    }
+
+    if (pending)
+        settings_table.modify(settings, same_payer, [&](auto& s) {
+            s.smart_currency.amount += pending;
+            s.pending_retire.emplace(0);
+        });
+    if (pending + amount > 0)
+        action(
+            permission_level{ get_self(), "active"_n },
+            settings.smart_contract, "retire"_n,
+            std::make_tuple(asset(pending + amount, settings.smart_currency.symbol), string("destroy on conversion"))
+        ).send();
+}
+
+// accumulates the log of the previous value of a reserve's weighted balance, or of the smart token supply, over the time it was held,
+// and records the new value
+void LegacyBancorConverter::update_price(symbol_code sym, double value, symbol_code pool) {
+    if (!(value > 0)) // empty reserves have no price
+        return;
+
+    const uint32_t now = current_time_point().sec_since_epoch();
+    prices prices_table(get_self(), pool_scope(pool));
+    auto existing = prices_table.find(sym.raw());
+    if (existing == prices_table.end())
+        prices_table.emplace(get_self(), [&](auto& p) {
+            p.symbol = sym;
+            p.log_value = log(value);
+            p.cumulative = 0;
+            p.last_update = now;
+        });
+    else prices_table.modify(existing, same_payer, [&](auto& p) {
+        p.cumulative += p.log_value * (now - p.last_update);
+        p.log_value = log(value);
+        p.last_update = now;
+    });
+}
+
+bool LegacyBancorConverter::is_pool_state_event_enabled(const settings_t& settings) {
+    return settings.pool_state_event.has_value() && settings.pool_state_event.value();
+}
+
+// emits the state of all the reserves in a single event
+// reserves already computed by the caller are passed in `updated_states`, the balances of the rest are read from their token contracts
+void LegacyBancorConverter::emit_pool_state(double smart_supply, const vector<reserve_state>& updated_states, symbol_code pool) {
+    reserves reserves_table(get_self(), pool_scope(pool));
+
+    vector<reserve_state> reserve_states;
+    for (const auto& reserve : reserves_table) {
+        const symbol_code reserve_symbol = reserve.currency.symbol.code();
+        auto updated = std::find_if(updated_states.begin(), updated_states.end(), [&](const reserve_state& state) {
+            return state.symbol == reserve_symbol;
+        });
+        if (updated != updated_states.end()) {
+            reserve_states.push_back(*updated);
+            continue;
+        }
+        double reserve_balance = amount_to_tokens(get_reserve_balance(reserve, pool), reserve.currency.symbol.precision());
+        reserve_states.push_back({ reserve.contract, reserve_symbol, reserve_balance, reserve.ratio / MAX_RATIO });
+    }
+    EMIT_POOL_STATE_EVENT(smart_supply, reserve_states);
+}
+
+// matches a "<keyword>" memo, or a "<keyword>:<pool>" memo on accounts hosting several pools
+static bool match_keyword(const string& memo, const string& keyword, symbol_code& pool) {
+    if (memo.compare(0, keyword.size(), keyword) != 0 || (memo.size() > keyword.size() && memo[keyword.size()] != ':'))
+        return false;
+
+    pool = memo.size() > keyword.size() ? symbol_code(memo.substr(keyword.size() + 1)) : symbol_code();
+    return true;
+}
+
+// returns the scope of the tables of a pool, `_self` on accounts holding a single pool
+uint64_t LegacyBancorConverter::pool_scope(symbol_code pool) {
+    return pool.raw() ? pool.raw() : get_self().value;
+}
+
+// whether `account` is the network of the single pool, or of any hosted pool, the pool of a conversion is only known from its path
+bool LegacyBancorConverter::is_network(name account) {
+    settings single_pool_settings(get_self(), get_self().value);
+    const auto st = single_pool_settings.find("settings"_n.value);
+    if (st != single_pool_settings.end())
+        return st->network == account;
+
+    pools pools_table(get_self(), get_self().value);
+    const auto pools_by_network = pools_table.get_index<"bynetwork"_n>();
+    return pools_by_network.find(account.value) != pools_by_network.end();
+}
+
+// returns the balance of a reserve including its virtual balance,
+// tracked in the reserve on accounts hosting several pools since they share the account's token balances,
+// read from the account's token balance otherwise, less the tokens deposited for a following batch conversion
+int64_t LegacyBancorConverter::get_reserve_balance(const reserve_t& reserve, symbol_code pool) {
+    if (pool.raw())
+        return reserve.balance.value_or(0) + reserve.currency.amount;
+
+    const symbol_code sym = reserve.currency.symbol.code();
+    deposits deposits_table(get_self(), get_self().value);
+    auto deposit = deposits_table.find(sym.raw());
+    const int64_t deposited = deposit == deposits_table.end() ? 0 : deposit->quantity.amount;
+    return get_balance_amount(reserve.contract, get_self(), sym) - deposited + reserve.currency.amount;
+}
+
+// updates the tracked balance of a reserve, the account's token balance is the balance of a single pool
+void LegacyBancorConverter::add_reserve_balance(symbol_code reserve, int64_t amount, symbol_code pool) {
+    if (!pool.raw() || !amount)
+        return;
+
+    reserves reserves_table(get_self(), pool.raw());
+    const auto& existing = reserves_table.get(reserve.raw(), "reserve not found");
+    reserves_table.modify(existing, same_payer, [&](auto& r) {
+        r.balance.emplace(r.balance.value_or(0) + amount);
+    });
+}
+
 // returns the balance object for an account
 asset LegacyBancorConverter::get_balance(name contract, name owner, symbol_code sym) {
     Token::accounts accountstable(contract, owner.value);
@@ -268,34 +644,9 @@ asset LegacyBancorConverter::get_supply(name contract, symbol_code sym) {
     return st.supply;
 }
 
-// given a token supply, reserve balance, ratio and a input amount (in the reserve token),
-// calculates the return for a given conversion (in the main token)
-double LegacyBancorConverter::calculate_purchase_return(double balance, double deposit_amount, double supply, int64_t ratio) {
-    double R(supply);
-    double C(balance);
-    double F(ratio / MAX_RATIO);
-    double T(deposit_amount);
-    double ONE(1.0);
-
-    double E = -R * (ONE - pow(ONE + T / C, F));
-    return E;
-}
-
-// given a token supply, reserve balance, ratio and a input amount (in the main token),
-// calculates the return for a given conversion (in the reserve token)
-double LegacyBancorConverter::calculate_sale_return(double balance, double sell_amount, double supply, int64_t ratio) {
-    double R(supply);
-    double C(balance);
-    double F(MAX_RATIO / ratio);
-    double E(sell_amount);
-    double ONE(1.0);
-
-    double T = C * (ONE - pow(ONE - E/R, F));
-    return T;
-}
-
-double LegacyBancorConverter::quick_convert(double balance, double in, double toBalance) {
-    return in / (balance + in) * toBalance;
+// returns the smart token supply in tokens, including the offset of the smart currency
+double LegacyBancorConverter::get_smart_supply(const settings_t& settings) {
+    return amount_to_tokens(get_supply(settings.smart_contract, settings.smart_currency.symbol.code()).amount + settings.smart_currency.amount, settings.smart_currency.symbol.precision());
 }
 
 void LegacyBancorConverter::on_transfer(name from, name to, asset quantity, std::string memo) {
@@ -306,16 +657,26 @@ void LegacyBancorConverter::on_transfer(name from, name to, asset quantity, std:
     if (from == get_self() || from == "eosio.ram"_n || from == "eosio.stake"_n || from == "eosio.rex"_n) 
 	    return;
 
-    if (memo == "setup") {
-        settings settings_table(get_self(), get_self().value);
-        const auto& converter_settings = settings_table.get("settings"_n.value, "settings do not exist");
-        const auto& reserve = get_reserve(quantity.symbol.code().raw(), converter_settings);
+    symbol_code pool;
+    if (match_keyword(memo, "setup", pool)) {
+        if (pool.raw())
+            fund(quantity, get_first_receiver(), pool);
 
-        auto current_smart_supply = (get_supply(converter_settings.smart_contract, converter_settings.smart_currency.symbol.code())).amount + converter_settings.smart_currency.amount;
-        current_smart_supply /= pow(10, converter_settings.smart_currency.symbol.precision());
-        auto reserve_balance = get_balance_amount(reserve.contract, get_self(), quantity.symbol.code()) / pow(10, quantity.symbol.precision()); 
+        settings settings_table(get_self(), pool_scope(pool));
+        const auto& converter_settings = settings_table.get("settings"_n.value, "settings do not exist");
+        const auto& reserve = get_reserve(quantity.symbol.code().raw(), converter_settings, pool);
+
+        auto current_smart_supply = get_smart_supply(converter_settings);
+        auto reserve_balance = amount_to_tokens(get_reserve_balance(reserve, pool), quantity.symbol.precision());
+        update_price(quantity.symbol.code(), reserve_balance / (reserve.ratio / MAX_RATIO), pool);
+        if (is_pool_state_event_enabled(converter_settings)) {
+            emit_pool_state(current_smart_supply, {}, pool);
+            return;
+        }
         
         EMIT_PRICE_DATA_EVENT(current_smart_supply, reserve.contract, quantity.symbol.code(), reserve_balance, reserve.ratio / MAX_RATIO);
-    } else 
+    } else if (match_keyword(memo, "batch", pool))
+        deposit(from, quantity, get_first_receiver(), pool);
+    else 
         convert(from, quantity, memo, get_first_receiver()); 
 }
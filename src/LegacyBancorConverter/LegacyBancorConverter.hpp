@@ -10,6 +10,9 @@
 #include <eosio/asset.hpp>
 #include <eosio/symbol.hpp>
 
+#include "../includes/Common/common.hpp"
+#include "../lib/bancor_formula.hpp"
+
 using namespace eosio;
 using namespace std;
 
@@ -18,6 +21,8 @@ using namespace std;
  * @brief Bancor Converter
  * @details The Bancor converter allows conversions between a smart token and tokens
  * that are defined as its reserves and between the different reserves directly.
+ * An account either holds a single pool, with its tables scoped by `_self`, or hosts many pools,
+ * with their tables scoped by the pool token symbol and selected by the `converter:symbol` syntax of the memo.
  * @{
 */
 
@@ -46,6 +51,24 @@ using namespace std;
     END_EVENT() \
 }
 
+/// triggered after a conversion with the state of all the reserves, replaces the price data events when enabled
+#define EMIT_POOL_STATE_EVENT(smart_supply, reserve_states) { \
+    START_EVENT("pool_state", "1.0") \
+    EVENTKV("smart_supply", smart_supply) \
+    print("\"reserves\":["); \
+    for (size_t i = 0; i < reserve_states.size(); i++) { \
+        if (i != 0) print(","); \
+        print("{"); \
+        EVENTKV("contract", reserve_states[i].contract) \
+        EVENTKV("symbol", reserve_states[i].symbol) \
+        EVENTKV("balance", reserve_states[i].balance) \
+        EVENTKVL("ratio", reserve_states[i].ratio) \
+        print("}"); \
+    } \
+    print("]"); \
+    END_EVENT() \
+}
+
 /// triggered when the conversion fee is updated
 #define EMIT_CONVERSION_FEE_UPDATE_EVENT(prev_fee, new_fee) { \
     START_EVENT("conversion_fee_update", "1.1") \
@@ -62,7 +85,8 @@ CONTRACT LegacyBancorConverter : public eosio::contract { /*! \endcond */
         /** 
          * @defgroup Converter_Settings_Table Settings Table
          * @brief This table stores stats on the settings of the converter
-         * @details Both SCOPE and PRIMARY KEY are `_self`, so this table is effectively a singleton.
+         * @details Both SCOPE and PRIMARY KEY are `_self`, so this table is effectively a singleton,
+         * on accounts hosting several pools SCOPE is the pool token symbol code.
          * @{
          *//*! \cond DOCS_EXCLUDE */
             TABLE settings_t { /*! \endcond */
@@ -105,6 +129,22 @@ CONTRACT LegacyBancorConverter : public eosio::contract { /*! \endcond */
                  * @brief conversion fee for this converter
                  */
                 uint64_t fee; 
+
+                /**
+                 * @brief true if a single pool state event replaces the per reserve price data events
+                 */
+                binary_extension<bool> pool_state_event;
+
+                /**
+                 * @brief pool tokens converted from are retired once this many are pending, 0 retires them on every conversion
+                 */
+                binary_extension<int64_t> retire_threshold;
+
+                /**
+                 * @brief pool tokens converted from but not retired yet, held by the converter and subtracted from `smart_currency`,
+                 * which is added to the supply, so that the supply the converter prices with does not include them
+                 */
+                binary_extension<int64_t> pending_retire;
                 
                 /*! \cond DOCS_EXCLUDE */
                 uint64_t primary_key() const { return "settings"_n.value; }  
@@ -115,7 +155,7 @@ CONTRACT LegacyBancorConverter : public eosio::contract { /*! \endcond */
             /** 
              * @defgroup Converter_Reserves_Table Reserves Table
              * @brief This table stores stats on the reserves of the converter, the actual balance is owned by converter account within the accounts 
-             * @details SCOPE of this table is `_self`
+             * @details SCOPE of this table is `_self`, or the pool token symbol code on accounts hosting several pools
              * @{
              *//*! \cond DOCS_EXCLUDE */
             TABLE reserve_t { /*! \endcond */
@@ -139,6 +179,16 @@ CONTRACT LegacyBancorConverter : public eosio::contract { /*! \endcond */
                  * @brief Are transactions enabled on this reserve
                  */
                 bool sale_enabled; 
+
+                /**
+                 * @brief Bonding curve coefficients precomputed from the ratio, missing on reserves set before they were introduced
+                 */
+                binary_extension<curve_coefficients> curve;
+
+                /**
+                 * @brief Reserve balance of a pool on an account hosting several pools, which share the account's token balances
+                 */
+                binary_extension<int64_t> balance;
                
                 /*! \cond DOCS_EXCLUDE */
                 uint64_t primary_key() const { return currency.symbol.code().raw(); } 
@@ -146,6 +196,115 @@ CONTRACT LegacyBancorConverter : public eosio::contract { /*! \endcond */
 
             }; /** @}*/
 
+            /** 
+             * @defgroup Converter_Pools_Table Pools Table
+             * @brief This table lists the pools hosted by an account hosting several pools, an account holds either a single pool or hosted pools
+             * @details SCOPE of this table is `_self`
+             * @{
+             *//*! \cond DOCS_EXCLUDE */
+            TABLE pool_t { /*! \endcond */
+                /**
+                 * @brief pool token symbol code of the hosted pool, the SCOPE of its tables
+                 * @details PRIMARY KEY is `pool.raw()`
+                 */
+                symbol_code pool;
+
+                /**
+                 * @brief network contract of the hosted pool, as in its settings
+                 * @details SECONDARY KEY of this table, looked up to accept route memos without knowing the pool
+                 */
+                name network;
+
+                /*! \cond DOCS_EXCLUDE */
+                uint64_t primary_key() const { return pool.raw(); }
+                uint64_t by_network() const { return network.value; }
+                /*! \endcond */
+
+            }; /** @}*/
+
+            /** 
+             * @defgroup Converter_Deposits_Table Deposits Table
+             * @brief This table stores the tokens deposited by the network for batch conversions, until they are converted
+             * @details SCOPE of this table is `_self`, or the pool token symbol code on accounts hosting several pools
+             * @{
+             *//*! \cond DOCS_EXCLUDE */
+            TABLE deposit_t { /*! \endcond */
+                /**
+                 * @brief deposited tokens that were not converted yet
+                 * @details PRIMARY KEY is `quantity.symbol.code().raw()`
+                 */
+                asset quantity;
+
+                /*! \cond DOCS_EXCLUDE */
+                uint64_t primary_key() const { return quantity.symbol.code().raw(); }
+                /*! \endcond */
+
+            }; /** @}*/
+
+            /** 
+             * @defgroup Converter_Prices_Table Prices Table
+             * @brief This table accumulates the prices of the converter over time, for time weighted average prices
+             * @details SCOPE of this table is `_self`, or the pool token symbol code on accounts hosting several pools,
+             * it holds a row per reserve for the log of its weighted balance (balance / ratio, in tokens), and a row for the smart token for the log of its supply.
+             * The price of reserve B in reserve A is `(balance A / ratio A) / (balance B / ratio B)` and the price of the smart token in reserve A is
+             * `(balance A / ratio A) / supply`, so the geometric mean of a price between two reads at t1 and t2 is
+             * `exp(((A2 - A1) - (B2 - B1)) / (t2 - t1))`, where A1 is the cumulative of A at t1, that is `cumulative + log_value * (t1 - last_update)`.
+             * Rows are only updated when their value changes, empty reserves keep their last value
+             * @{
+             *//*! \cond DOCS_EXCLUDE */
+            TABLE price_t { /*! \endcond */
+                /**
+                 * @brief symbol of the reserve, or of the smart token
+                 * @details PRIMARY KEY is `symbol.raw()`
+                 */
+                symbol_code symbol;
+
+                /**
+                 * @brief log of the weighted balance, or of the supply, since `last_update`
+                 */
+                double log_value;
+
+                /**
+                 * @brief sum of `log_value` over every second until `last_update`
+                 */
+                double cumulative;
+
+                /**
+                 * @brief time of the last change of the value, in seconds since epoch
+                 */
+                uint32_t last_update;
+
+                /*! \cond DOCS_EXCLUDE */
+                uint64_t primary_key() const { return symbol.raw(); }
+                /*! \endcond */
+
+            }; /** @}*/
+
+        /**
+         * @brief a single hop conversion of a batch
+         */
+        struct batch_conversion {
+            /**
+             * @brief account that receives the return
+             */
+            name recipient;
+
+            /**
+             * @brief tokens to convert, deposited beforehand by the network
+             */
+            asset quantity;
+
+            /**
+             * @brief minimum return, its symbol is the token to convert to
+             */
+            asset min_return;
+
+            /**
+             * @brief memo of the original conversion, reported in the conversion event
+             */
+            std::string memo;
+        };
+
         /**
          * @brief initializes the converter settings
          * @details can only be called once, by the contract account
@@ -157,8 +316,9 @@ CONTRACT LegacyBancorConverter : public eosio::contract { /*! \endcond */
          * @param network - bancor network contract name
          * @param max_fee - maximum conversion fee percentage, 0-30000, 4-pt precision a la eosio.asset
          * @param fee - conversion fee percentage, must be lower than the maximum fee, same precision
+         * @param pool - symbol of the smart currency, to initialize one of several pools hosted by the account
          */ 
-        ACTION init(name smart_contract, asset smart_currency, bool smart_enabled, bool enabled, name network, bool require_balance, uint64_t max_fee, uint64_t fee);
+        ACTION init(name smart_contract, asset smart_currency, bool smart_enabled, bool enabled, name network, bool require_balance, uint64_t max_fee, uint64_t fee, binary_extension<symbol_code> pool);
 
         /**
          * @brief updates the converter settings
@@ -167,8 +327,35 @@ CONTRACT LegacyBancorConverter : public eosio::contract { /*! \endcond */
          * @param enabled - true if conversions are enabled, false if not
          * @param require_balance - true if conversions that require creating new balance for the calling account should fail, false if not
          * @param fee - conversion fee percentage, must be lower than the maximum fee, same precision
+         * @param pool - pool token symbol, on accounts hosting several pools
+         */
+        ACTION update(bool smart_enabled, bool enabled, bool require_balance, uint64_t fee, binary_extension<symbol_code> pool);
+
+        /**
+         * @brief toggles the pool state event
+         * @details when enabled, conversions emit a single event with the state of all the reserves instead of a price data event per reserve,
+         * can only be called by the contract account
+         * @param enabled - true if the pool state event should be emitted, false for the per reserve price data events
+         * @param pool - pool token symbol, on accounts hosting several pools
+         */
+        ACTION setpoolevent(bool enabled, binary_extension<symbol_code> pool);
+
+        /**
+         * @brief sets the amount of pool tokens converted from that are retired together
+         * @details below the threshold, pool tokens converted from stay with the converter and only their amount is recorded,
+         * so that conversions from the pool token do not send a retire action each, 0 retires them on every conversion again,
+         * and retires the pending ones, can only be called by the contract account
+         * @param threshold - amount of pending pool tokens that triggers their retirement, 0 to retire on every conversion
+         * @param pool - pool token symbol, on accounts hosting several pools
+         */
+        ACTION setretire(int64_t threshold, binary_extension<symbol_code> pool);
+
+        /**
+         * @brief retires the pending pool tokens, see `setretire`
+         * @details can be called by anyone, e.g. periodically by a keeper
+         * @param pool - pool token symbol, on accounts hosting several pools
          */
-        ACTION update(bool smart_enabled, bool enabled, bool require_balance, uint64_t fee);
+        ACTION retirepend(binary_extension<symbol_code> pool);
 
         /**
          * @brief initializes a new reserve in the converter
@@ -177,19 +364,44 @@ CONTRACT LegacyBancorConverter : public eosio::contract { /*! \endcond */
          * @param currency - reserve token currency symbol
          * @param ratio - reserve ratio, percentage, 0-1000000, precision a la max_fee
          * @param sale_enabled - true if purchases are enabled with the reserve, false if not
+         * @param pool - pool token symbol, on accounts hosting several pools
          */ 
-        ACTION setreserve(name contract, symbol currency, uint64_t ratio, bool sale_enabled);
+        ACTION setreserve(name contract, symbol currency, uint64_t ratio, bool sale_enabled, binary_extension<symbol_code> pool);
 
         /**
          * @brief deletes an empty reserve
          * @param currency - reserve token currency symbol
+         * @param pool - pool token symbol, on accounts hosting several pools
          */
-        ACTION delreserve(symbol_code currency);
+        ACTION delreserve(symbol_code currency, binary_extension<symbol_code> pool);
+
+        /**
+         * @brief converts a batch of single hop conversions submitted by the network
+         * @details the conversions are evaluated in order against reserve balances read once, with the same returns as if
+         * each was sent to the converter on its own, the returns are then paid with a single transfer per recipient and token
+         * and the pool tokens converted from and to are netted into a single retire or issue,
+         * can only be called by the network contract
+         * @param conversions - the conversions, their quantities must have been deposited with "batch" transfers
+         * @param pool - pool token symbol, on accounts hosting several pools
+         */
+        ACTION convertbatch(const vector<batch_conversion>& conversions, binary_extension<symbol_code> pool);
+
+        /**
+         * @brief returns deposited tokens that will not be converted, e.g. when their batch failed
+         * @details can only be called by the network contract
+         * @param recipient - account receiving the tokens
+         * @param quantity - quantity to return, up to the deposited quantity
+         * @param pool - pool token symbol, on accounts hosting several pools
+         */
+        ACTION refund(name recipient, asset quantity, binary_extension<symbol_code> pool);
 
         /**
          * @brief transfer intercepts
-         * @details `memo` in csv format, may contain an extra keyword (e.g. "setup") following a semicolon at the end of the conversion path; 
-         * indicates special transfer which otherwise would be interpreted as a standard conversion
+         * @details `memo` in csv format, or a compact version 2 memo that may reference a route registered on the network,
+         * may contain an extra keyword (e.g. "setup") following a semicolon at the end of the conversion path; 
+         * indicates special transfer which otherwise would be interpreted as a standard conversion,
+         * a "batch" memo deposits the tokens for a following `convertbatch`,
+         * on accounts hosting several pools these keywords are followed by the pool token symbol, e.g. "setup:BNTDDD"
          * @param from - the sender of the transfer
          * @param to - the receiver of the transfer
          * @param quantity - the quantity for the transfer
@@ -200,19 +412,52 @@ CONTRACT LegacyBancorConverter : public eosio::contract { /*! \endcond */
         
         typedef eosio::multi_index<"settings"_n, settings_t> settings;
         typedef eosio::multi_index<"reserves"_n, reserve_t> reserves; 
+        typedef eosio::multi_index<"pools"_n, pool_t,
+                        indexed_by<"bynetwork"_n, const_mem_fun<pool_t, uint64_t, &pool_t::by_network>>> pools;
+        typedef eosio::multi_index<"deposits"_n, deposit_t> deposits;
+        typedef eosio::multi_index<"prices"_n, price_t> prices;
+        typedef eosio::multi_index<"routes"_n, route_t> routes; // owned by the network, read by version 2 memos
     
     private:
+        struct reserve_state {
+            name contract;
+            symbol_code symbol;
+            double balance;
+            double ratio;
+        };
+
+        // a reserve (or the smart token) taking part in a batch conversion
+        struct batch_reserve {
+            reserve_t reserve;
+            bool smart;
+            int64_t balance; // excluding the deposits that were not converted yet
+            int64_t initial_balance;
+            int64_t deposited;
+        };
+
         using transfer_action = action_wrapper<name("transfer"), &LegacyBancorConverter::on_transfer>;
     
         void convert(name from, eosio::asset quantity, std::string memo, name code);
-        const reserve_t& get_reserve(uint64_t name, const settings_t& settings);
+        void fund(asset quantity, name code, symbol_code pool);
+        const reserve_t& get_reserve(uint64_t name, const settings_t& settings, symbol_code pool);
+        void deposit(name from, asset quantity, name code, symbol_code pool);
+        size_t get_batch_reserve(vector<batch_reserve>& batch, symbol_code sym, const settings_t& settings, symbol_code pool);
+
+        uint64_t pool_scope(symbol_code pool);
+        bool is_network(name account);
+        int64_t get_reserve_balance(const reserve_t& reserve, symbol_code pool);
+        void add_reserve_balance(symbol_code reserve, int64_t amount, symbol_code pool);
+
+        void retire_smart(settings& settings_table, const settings_t& settings, int64_t amount, bool flush);
+
+        void update_price(symbol_code sym, double value, symbol_code pool);
+
+        bool is_pool_state_event_enabled(const settings_t& settings);
+        void emit_pool_state(double smart_supply, const vector<reserve_state>& updated_states, symbol_code pool);
 
         asset get_balance(name contract, name owner, symbol_code sym);
         uint64_t get_balance_amount(name contract, name owner, symbol_code sym);
         asset get_supply(name contract, symbol_code sym);
-
-        double calculate_purchase_return(double balance, double deposit_amount, double supply, int64_t ratio);
-        double calculate_sale_return(double balance, double sell_amount, double supply, int64_t ratio);
-        double quick_convert(double balance, double in, double toBalance);
+        double get_smart_supply(const settings_t& settings);
 
 }; /** @}*/
\ No newline at end of file
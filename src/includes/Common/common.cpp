@@ -0,0 +1,342 @@
+/**
+ *  @file
+ *  @copyright defined in ../../../LICENSE
+ */
+
+#include "common.hpp"
+
+static vector<string> split(const string& str, const string& delim) {
+    vector<string> tokens;
+    size_t prev = 0, pos = 0;
+    do {
+        pos = str.find(delim, prev);
+        if (pos == string::npos) pos = str.length();
+        string token = str.substr(prev, pos-prev);
+        tokens.push_back(token);
+        prev = pos + delim.length();
+    } while (pos < str.length() && prev < str.length());
+
+    return tokens;
+}
+
+static const char BASE64URL_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+// base64url without padding, none of its characters are memo delimiters
+static string to_base64url(const vector<uint8_t>& data) {
+    string str;
+    str.reserve((data.size() * 4 + 2) / 3);
+    for (size_t i = 0; i < data.size(); i += 3) {
+        const uint32_t bits = (data[i] << 16) | (i + 1 < data.size() ? data[i + 1] << 8 : 0) | (i + 2 < data.size() ? data[i + 2] : 0);
+        const size_t chars = std::min<size_t>(data.size() - i, 3) + 1;
+        for (size_t j = 0; j < chars; j++)
+            str.push_back(BASE64URL_CHARS[(bits >> (18 - 6 * j)) & 0x3f]);
+    }
+    return str;
+}
+
+static vector<uint8_t> from_base64url(const string& str) {
+    check(str.size() % 4 != 1, "invalid memo payload");
+    vector<uint8_t> data;
+    data.reserve(str.size() * 3 / 4);
+    uint32_t bits = 0;
+    int bit_count = 0;
+    for (char c : str) {
+        uint32_t value;
+        if (c >= 'A' && c <= 'Z') value = c - 'A';
+        else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') value = c - '0' + 52;
+        else if (c == '-') value = 62;
+        else if (c == '_') value = 63;
+        else check(false, "invalid memo payload");
+
+        bits = (bits << 6) | value;
+        bit_count += 6;
+        if (bit_count >= 8) {
+            bit_count -= 8;
+            data.push_back((bits >> bit_count) & 0xff);
+        }
+    }
+    return data;
+}
+
+// e.g. - to_decimal_string(1, 8) --> "0.00000001"
+static string to_decimal_string(uint64_t amount, uint8_t precision) {
+    string digits = std::to_string(amount);
+    if (precision == 0)
+        return digits;
+    if (digits.size() <= precision)
+        digits.insert(0, precision + 1 - digits.size(), '0');
+    digits.insert(digits.size() - precision, ".");
+    return digits;
+}
+
+// the number of digits after the decimal point
+static uint8_t decimal_places(const string& value) {
+    const size_t point = value.find('.');
+    return point == string::npos ? 0 : value.size() - point - 1;
+}
+
+// the binary payload of version 2 memos: names as their 64 bit values, symbol codes prefixed by their length,
+// and decimals (min return, affiliate fee) as a variable length integer amount followed by their precision
+enum compact_memo_flags : uint8_t {
+    ROUTE_FLAG = 1,
+    TRADER_FLAG = 2,
+    AFFILIATE_FLAG = 4
+};
+
+struct compact_writer {
+    vector<uint8_t> data;
+
+    void byte(uint8_t value) { data.push_back(value); }
+    void fixed(uint64_t value) {
+        for (int i = 0; i < 8; i++)
+            data.push_back(value >> (8 * i));
+    }
+    void varuint(uint64_t value) {
+        do {
+            data.push_back((value & 0x7f) | (value >= 0x80 ? 0x80 : 0));
+            value >>= 7;
+        } while (value);
+    }
+    void str(const string& value) {
+        check(value.size() <= 0xff, "memo field is too long");
+        byte(value.size());
+        data.insert(data.end(), value.begin(), value.end());
+    }
+    void decimal(const string& value) {
+        const uint8_t precision = decimal_places(value);
+        varuint(to_scaled_amount(value, precision));
+        byte(precision);
+    }
+};
+
+struct compact_reader {
+    const vector<uint8_t>& data;
+    size_t pos = 0;
+
+    uint8_t byte() {
+        check(pos < data.size(), "invalid memo payload");
+        return data[pos++];
+    }
+    uint64_t fixed() {
+        uint64_t value = 0;
+        for (int i = 0; i < 8; i++)
+            value |= uint64_t(byte()) << (8 * i);
+        return value;
+    }
+    uint64_t varuint() {
+        uint64_t value = 0;
+        for (int shift = 0; ; shift += 7) {
+            check(shift < 64, "invalid memo payload");
+            const uint8_t b = byte();
+            value |= uint64_t(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                return value;
+        }
+    }
+    string str() {
+        const uint8_t size = byte();
+        check(data.size() - pos >= size, "invalid memo payload");
+        pos += size;
+        return string(data.begin() + pos - size, data.begin() + pos);
+    }
+    string decimal() {
+        const uint64_t amount = varuint();
+        return to_decimal_string(amount, byte());
+    }
+};
+
+static string build_compact_memo(const memo_structure& data) {
+    check(data.path.size() % 2 == 0, "invalid memo format");
+    compact_writer writer;
+    writer.byte((data.route_id ? ROUTE_FLAG : 0) | (data.trader_account.empty() ? 0 : TRADER_FLAG) | (data.affiliate_account.empty() ? 0 : AFFILIATE_FLAG));
+    if (data.route_id) {
+        writer.varuint(data.route_id);
+        writer.byte(data.route_hops - data.path.size() / 2);
+    }
+    else {
+        check(data.path.size() / 2 <= 0xff, "invalid memo format");
+        writer.byte(data.path.size() / 2);
+        for (size_t i = 0; i < data.path.size(); i += 2) {
+            const size_t separator = data.path[i].find(':');
+            writer.fixed(name(data.path[i].substr(0, separator)).value);
+            writer.str(separator == string::npos ? "" : data.path[i].substr(separator + 1));
+            writer.str(data.path[i + 1]);
+        }
+    }
+
+    writer.decimal(data.min_return);
+    writer.fixed(name(data.dest_account).value);
+    if (!data.trader_account.empty())
+        writer.fixed(name(data.trader_account).value);
+    if (!data.affiliate_account.empty()) {
+        writer.fixed(name(data.affiliate_account).value);
+        writer.decimal(data.affiliate_fee);
+    }
+
+    string memo = data.version + "," + to_base64url(writer.data);
+    if (data.receiver_memo != "convert")
+        memo.append(";").append(data.receiver_memo);
+    return memo;
+}
+
+// fills the converters of a memo from its path
+static void set_converters(memo_structure& data) {
+    data.converters = {};
+    for (size_t i = 0; i < data.path.size(); i += 2) {
+        const size_t separator = data.path[i].find(':');
+        auto cnvrt = converter();
+        cnvrt.account = name(data.path[i].substr(0, separator));
+        cnvrt.sym = separator == string::npos ? "" : data.path[i].substr(separator + 1);
+        data.converters.push_back(cnvrt);
+    }
+}
+
+static void parse_compact_memo(memo_structure& res, const string& payload) {
+    const vector<uint8_t> data = from_base64url(payload);
+    compact_reader reader{ data };
+    const uint8_t flags = reader.byte();
+    if (flags & ROUTE_FLAG) {
+        res.route_id = reader.varuint();
+        check(res.route_id != 0, "invalid route");
+        res.route_offset = reader.byte();
+    }
+    else {
+        const uint8_t hops = reader.byte();
+        for (uint8_t i = 0; i < hops; i++) {
+            const string account = name(reader.fixed()).to_string();
+            const string pool = reader.str();
+            res.path.push_back(pool.empty() ? account : account + ":" + pool);
+            res.path.push_back(reader.str());
+        }
+        set_converters(res);
+    }
+
+    res.min_return = reader.decimal();
+    res.dest_account = name(reader.fixed()).to_string();
+    if (flags & TRADER_FLAG)
+        res.trader_account = name(reader.fixed()).to_string();
+    if (flags & AFFILIATE_FLAG) {
+        res.affiliate_account = name(reader.fixed()).to_string();
+        res.affiliate_fee = reader.decimal();
+    }
+    check(reader.pos == data.size(), "invalid memo payload");
+}
+
+string build_memo(const memo_structure& data) {
+    if (data.version == "2")
+        return build_compact_memo(data);
+
+    string pathstr = "";
+    for (size_t i = 0; i < data.path.size(); i++) {
+        if (i != 0) pathstr.append(" ");
+        pathstr.append(data.path[i]);
+    }
+    string memo = "";
+    memo.append(data.version);
+    memo.append(",");
+    memo.append(pathstr);
+    memo.append(",");
+    memo.append(data.min_return);
+    memo.append(",");
+    memo.append(data.dest_account);
+    if (!data.trader_account.empty()) {
+        memo.append(",");
+        memo.append(data.trader_account);
+    }
+    if (!data.affiliate_account.empty()) {
+        memo.append(",");
+        memo.append(data.affiliate_account);
+        memo.append(",");
+        memo.append(data.affiliate_fee);
+    }
+    memo.append(";");
+    memo.append(data.receiver_memo);
+
+    return memo;
+}
+
+int64_t to_scaled_amount(const string& value, uint8_t precision) {
+    int64_t amount = 0;
+    int decimals = -1;
+    for (char c : value) {
+        if (c == '.') {
+            check(decimals == -1, "invalid decimal number");
+            decimals = 0;
+            continue;
+        }
+        check(c >= '0' && c <= '9', "invalid decimal number");
+        if (decimals == precision) continue;
+        check(amount <= (asset::max_amount - (c - '0')) / 10, "decimal number is out of range");
+        amount = amount * 10 + (c - '0');
+        if (decimals != -1) decimals++;
+    }
+    for (int i = decimals == -1 ? 0 : decimals; i < precision; i++) {
+        check(amount <= asset::max_amount / 10, "decimal number is out of range");
+        amount *= 10;
+    }
+    return amount;
+}
+
+memo_structure parse_memo(const string& memo) {
+    memo_structure res = memo_structure();
+    
+    vector<string> split_memos = split(memo, ";"); // we separate concantenated memos with ";"
+    vector<string> parts = split(split_memos[0], ","); // split the first memo by ","
+
+    if (split_memos.size() == 2)
+        res.receiver_memo = split_memos[1];
+    else
+        res.receiver_memo = "convert"; // default memo for receiver account
+
+    if (parts[0] == "2") {
+        check(parts.size() == 2, "invalid memo");
+        res.version = parts[0];
+        parse_compact_memo(res, parts[1]);
+        return res;
+    }
+    
+    check(parts.size() >= 4 && parts.size() <= 7, "invalid memo");
+    
+    res.version = parts[0];
+
+    auto path_elements = split(parts[1], " ");
+
+    if (path_elements.size() == 1 && path_elements[0] == "")
+        res.path = {};
+    else
+        res.path = path_elements;
+    
+    set_converters(res);
+
+    res.min_return = parts[2];
+    res.dest_account = parts[3];
+    
+    // supplying an affiliate account without affiliate fee 
+    // will interpret ^account as sender of the conversion (trader_account)
+    if (parts.size() == 5) { // or no affiliate parts at all
+        res.trader_account = parts[4];
+    }
+    // affiliate parts present, but sender (trader) not yet set
+    else if (parts.size() == 6) { 
+        res.affiliate_account = parts[4];
+        res.affiliate_fee = parts[5];
+    }
+    // affiliate parts present, AND sender (trader) already set
+    else if (parts.size() == 7) {
+        res.trader_account = parts[4];
+        res.affiliate_account = parts[5];
+        res.affiliate_fee = parts[6];
+    }
+    if (!res.affiliate_fee.empty())
+        to_scaled_amount(res.affiliate_fee, decimal_places(res.affiliate_fee)); // rejects fees that are not decimal numbers
+    return res;
+}
+
+void resolve_route(memo_structure& data, const route_t& route) {
+    check(route.path.size() % 2 == 0 && data.route_offset * 2 <= route.path.size(), "invalid route offset");
+
+    data.route_hops = route.path.size() / 2;
+    data.path = ::path(route.path.begin() + data.route_offset * 2, route.path.end());
+    set_converters(data);
+}
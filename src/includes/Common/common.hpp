@@ -12,6 +12,9 @@
 #include <algorithm>
 #include <math.h>
 #include "events.hpp"
+#include "../../lib/asset_math.hpp"
+#include "../../lib/bancor_formula.hpp"
+#include "../../lib/check_format.hpp"
 
 using namespace eosio;
 using namespace std;
@@ -24,7 +27,7 @@ struct converter {
 };
 
 struct memo_structure {
-    path path;
+    ::path path;
     vector<converter> converters;
     string version;
     string min_return;
@@ -33,152 +36,42 @@ struct memo_structure {
     string affiliate_account;
     string affiliate_fee;
     string receiver_memo;
+    uint64_t route_id = 0;    // version 2 memos, the route registered on the network, 0 when the path is in the memo
+    uint8_t route_offset = 0; // hops of the route already taken
+    uint8_t route_hops = 0;   // hops of the route, known once it is resolved
 };
 
-constexpr static double MAX_RATIO = 1000000.0;
-constexpr static double MAX_FEE = 1000000.0;
+/**
+ * @brief a conversion path registered on the network, referenced by id from version 2 memos
+ * @details rows of the network's routes table, SCOPE of that table is the network account
+ */
+struct route_t {
+    uint64_t id;
+    ::path path;
 
-vector<string> split(const string& str, const string& delim) {
-    vector<string> tokens;
-    size_t prev = 0, pos = 0;
-    do {
-        pos = str.find(delim, prev);
-        if (pos == string::npos) pos = str.length();
-        string token = str.substr(prev, pos-prev);
-        tokens.push_back(token);
-        prev = pos + delim.length();
-    } while (pos < str.length() && prev < str.length());
-
-    return tokens;
-}
-
-string build_memo(memo_structure data) {
-    string pathstr = "";
-    for (auto i = 0; i < data.path.size(); i++) {
-        if (i != 0) pathstr.append(" ");
-        pathstr.append(data.path[i]);
-    }
-    string memo = "";
-    memo.append(data.version);
-    memo.append(",");
-    memo.append(pathstr);
-    memo.append(",");
-    memo.append(data.min_return);
-    memo.append(",");
-    memo.append(data.dest_account);
-    if (!data.trader_account.empty()) {
-        memo.append(",");
-        memo.append(data.trader_account);
-    }
-    if (!data.affiliate_account.empty()) {
-        memo.append(",");
-        memo.append(data.affiliate_account);
-        memo.append(",");
-        memo.append(data.affiliate_fee);
-    }
-    memo.append(";");
-    memo.append(data.receiver_memo);
-
-    return memo;
-}
+    uint64_t primary_key() const { return id; }
+};
 
-/** @dev to_fixed 
- *  formats a number to a fixed precision
- *  e.g. - to_fixed(14.214212, 3) --> 14.214
+/** @dev build_memo
+ *  serializes a memo structure back into the conversion memo format of its version,
+ *  a route memo takes the hops removed from its path as taken
 */
-double to_fixed(double num, int precision) {
-    return (int)(num * pow(10.0, precision)) / pow(10.0, precision);
-}
-
-float stof(const char* s) {
-    float rez = 0, fact = 1;
-
-    if (*s == '-') {
-        s++;
-        fact = -1;
-    }
-    for (int point_seen = 0; *s; s++) {
-        if (*s == '.') {
-            if (point_seen) return 0;
-            point_seen = 1; 
-            continue;
-        }
-        int d = *s - '0';
-        if (d >= 0 && d <= 9) {
-            if (point_seen) fact /= 10.0f;
-            rez = rez * 10.0f + (float)d;
-        } else return 0;
-    }
-    return rez * fact;
-}
+string build_memo(const memo_structure& data);
 
-double calculate_fee(double amount, uint64_t fee, uint8_t magnitude) {
-    return amount * (1 - pow((1 - fee / MAX_FEE), magnitude));
-}
-
-uint64_t stoui(string const& value) {
-  uint64_t result = 0;
-  size_t const length = value.size();
-  switch (length) {
-    case 7: result += (value[length -  7] - '0') * 1000000ULL;
-    case 6: result += (value[length -  6] - '0') * 100000ULL;
-    case 5: result += (value[length -  5] - '0') * 10000ULL;
-    case 4: result += (value[length -  4] - '0') * 1000ULL;
-    case 3: result += (value[length -  3] - '0') * 100ULL;
-    case 2: result += (value[length -  2] - '0') * 10ULL;
-    case 1: result += (value[length -  1] - '0');
-  }
-  return result;
-}
-
-memo_structure parse_memo(string memo) {
-    memo_structure res = memo_structure();
-    
-    vector<string> split_memos = split(memo, ";"); // we separate concantenated memos with ";"
-    vector<string> parts = split(split_memos[0], ","); // split the first memo by ","
-    
-    check(parts.size() >= 4 && parts.size() <= 7, "invalid memo");
-    
-    res.converters = {};
-    res.version = parts[0];
-
-    auto path_elements = split(parts[1], " ");
+/** @dev parse_memo
+ *  parses a conversion memo: `version,path,min_return,dest_account[,trader_account][,affiliate_account,affiliate_fee][;receiver_memo]`
+ *  or a compact version 2 memo: `2,payload[;receiver_memo]`, with the rest of the memo packed in base64url,
+ *  the path of a version 2 memo that references a route is empty until `resolve_route`
+*/
+memo_structure parse_memo(const string& memo);
 
-    if (path_elements.size() == 1 && path_elements[0] == "")
-        res.path = {};
-    else
-        res.path = path_elements;
-    
-    for (int i = 0; i < res.path.size(); i += 2) {
-        auto converter_data = split(res.path[i], ":");
-        auto cnvrt = converter();
-        cnvrt.account = name(converter_data[0].c_str());
-        cnvrt.sym = converter_data.size() > 1 ? converter_data[1] : "";
-        res.converters.push_back(cnvrt);
-    }
-    if (split_memos.size() == 2)
-        res.receiver_memo = split_memos[1];
-    else
-        res.receiver_memo = "convert"; // default memo for receiver account
+/** @dev resolve_route
+ *  sets the remaining path of a route memo from its route, as read from the routes of the network
+*/
+void resolve_route(memo_structure& data, const route_t& route);
 
-    res.min_return = parts[2];
-    res.dest_account = parts[3];
-    
-    // supplying an affiliate account without affiliate fee 
-    // will interpret ^account as sender of the conversion (trader_account)
-    if (parts.size() == 5) { // or no affiliate parts at all
-        res.trader_account = parts[4];
-    }
-    // affiliate parts present, but sender (trader) not yet set
-    else if (parts.size() == 6) { 
-        res.affiliate_account = parts[4];
-        res.affiliate_fee = parts[5];
-    }
-    // affiliate parts present, AND sender (trader) already set
-    else if (parts.size() == 7) {
-        res.trader_account = parts[4];
-        res.affiliate_account = parts[5];
-        res.affiliate_fee = parts[6];
-    }
-    return res;
-}
+/** @dev to_scaled_amount
+ *  parses a non negative decimal string into an integer amount at the given precision, extra decimals are truncated
+ *  e.g. - to_scaled_amount("14.214212", 3) --> 14214
+*/
+int64_t to_scaled_amount(const string& value, uint8_t precision);
@@ -0,0 +1,95 @@
+/**
+ *  @file
+ *  @copyright defined in ../../../LICENSE
+ */
+#pragma once
+
+#include <math.h>
+#include <eosio/eosio.hpp>
+#include <eosio/asset.hpp>
+
+/**
+ * @defgroup AssetMath Asset Math
+ * @brief checked integer arithmetic on asset amounts
+ * @details amounts are kept as integers in their token's precision, products are computed on 128 bits
+ * and every result is checked to fit in an asset amount
+ * @{
+ */
+
+enum class rounding_mode : uint8_t {
+    down,
+    up,
+    nearest
+};
+
+constexpr uint8_t MAX_ASSET_PRECISION = 18;
+
+/** @dev precision_factor
+ *  returns 10^precision, the number of amount units in a single token
+ *  e.g. - precision_factor(4) --> 10000
+*/
+constexpr uint64_t precision_factor(uint8_t precision) {
+    uint64_t factor = 1;
+    for (uint8_t i = 0; i < precision; i++)
+        factor *= 10;
+    return factor;
+}
+
+/** @dev divide
+ *  divides a 128 bit numerator, rounding the quotient according to the given mode
+*/
+inline uint128_t divide(uint128_t numerator, uint128_t denominator, rounding_mode mode) {
+    eosio::check(denominator != 0, "division by zero");
+    uint128_t quotient = numerator / denominator;
+    const uint128_t remainder = numerator % denominator;
+
+    if (remainder != 0 && (mode == rounding_mode::up || (mode == rounding_mode::nearest && remainder * 2 >= denominator)))
+        quotient++;
+
+    return quotient;
+}
+
+/** @dev checked_amount
+ *  asserts that a 128 bit result is a valid asset amount
+*/
+inline int64_t checked_amount(uint128_t value) {
+    eosio::check(value <= uint128_t(eosio::asset::max_amount), "asset amount overflow");
+    return int64_t(value);
+}
+
+/** @dev mul_div
+ *  returns a * b / c without overflowing on the intermediate product
+ *  e.g. - mul_div(5, 3, 2) --> 7, mul_div(5, 3, 2, rounding_mode::up) --> 8
+*/
+inline int64_t mul_div(int64_t a, int64_t b, int64_t c, rounding_mode mode = rounding_mode::down) {
+    eosio::check(a >= 0 && b >= 0 && c > 0, "mul_div operands must be positive");
+    return checked_amount(divide(uint128_t(a) * uint128_t(b), uint128_t(c), mode));
+}
+
+/** @dev amount_to_tokens
+ *  converts an amount to a number of tokens
+ *  e.g. - amount_to_tokens(14214, 3) --> 14.214
+*/
+inline double amount_to_tokens(int64_t amount, uint8_t precision) {
+    return amount / double(precision_factor(precision));
+}
+
+/** @dev tokens_to_amount
+ *  converts a number of tokens, e.g. the result of a bonding curve formula, to an amount in the given precision
+ *  e.g. - tokens_to_amount(14.214212, 3) --> 14214
+*/
+inline int64_t tokens_to_amount(double tokens, uint8_t precision, rounding_mode mode = rounding_mode::down) {
+    eosio::check(precision <= MAX_ASSET_PRECISION, "invalid precision");
+    double amount = tokens * precision_factor(precision);
+    if (mode == rounding_mode::down)
+        amount = floor(amount);
+    else if (mode == rounding_mode::up)
+        amount = ceil(amount);
+    else
+        amount = round(amount);
+
+    eosio::check(amount >= 0 && amount <= double(eosio::asset::max_amount), "asset amount overflow");
+    return int64_t(amount);
+}
+
+/** @}*/
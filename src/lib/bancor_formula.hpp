@@ -0,0 +1,247 @@
+/**
+ *  @file
+ *  @copyright defined in ../../../LICENSE
+ */
+#pragma once
+
+#include "asset_math.hpp"
+
+/**
+ * @defgroup BancorFormula Bancor Formula
+ * @brief the bonding curve math of the legacy converter
+ * @details shared by the contract and the native tools (e.g. the pool simulator), so that both produce the exact same returns
+ * @{
+ */
+
+constexpr static double MAX_RATIO = 1000000.0;
+constexpr static double MAX_FEE = 1000000.0;
+
+/**
+ * @brief the power function a reserve's bonding curve needs, chosen by its ratio
+ */
+enum class curve_kernel : uint8_t {
+    generic = 0,     // pow(1 + x, exponent)
+    linear = 1,      // ratio of 100%, both exponents are 1
+    square_root = 2  // ratio of 50%, a square root on purchase and a square on sale
+};
+
+/**
+ * @brief the bonding curve coefficients of a reserve, precomputed from its ratio when the reserve is set
+ */
+struct curve_coefficients {
+    /**
+     * @brief the curve_kernel for the ratio
+     */
+    uint8_t kernel;
+
+    /**
+     * @brief ratio / MAX_RATIO, the exponent of a purchase
+     */
+    double purchase_exponent;
+
+    /**
+     * @brief MAX_RATIO / ratio, the exponent of a sale
+     */
+    double sale_exponent;
+};
+
+/** @dev make_curve_coefficients
+ *  precomputes the curve coefficients of a ratio
+ *  e.g. - make_curve_coefficients(250000) --> { generic, 0.25, 4 }
+*/
+inline curve_coefficients make_curve_coefficients(uint64_t ratio) {
+    eosio::check(ratio > 0 && ratio <= MAX_RATIO, "invalid ratio");
+    curve_kernel kernel = curve_kernel::generic;
+    if (ratio == MAX_RATIO)
+        kernel = curve_kernel::linear;
+    else if (ratio * 2 == MAX_RATIO)
+        kernel = curve_kernel::square_root;
+
+    return { uint8_t(kernel), ratio / MAX_RATIO, MAX_RATIO / ratio };
+}
+
+/** @dev curve_power
+ *  returns (1 + x)^exponent, with the cheapest kernel for the curve, x > -1
+*/
+inline double curve_power(double x, const curve_coefficients& curve, bool sale) {
+    switch (curve_kernel(curve.kernel)) {
+        case curve_kernel::linear:
+            return 1.0 + x;
+        case curve_kernel::square_root:
+            return sale ? (1.0 + x) * (1.0 + x) : sqrt(1.0 + x);
+        default:
+            return pow(1.0 + x, sale ? curve.sale_exponent : curve.purchase_exponent);
+    }
+}
+
+/** @dev calculate_purchase_return
+ *  given a token supply, reserve balance, curve and a input amount (in the reserve token),
+ *  calculates the return for a given conversion (in the main token)
+*/
+inline double calculate_purchase_return(double balance, double deposit_amount, double supply, const curve_coefficients& curve) {
+    double R(supply);
+    double C(balance);
+    double T(deposit_amount);
+    double ONE(1.0);
+
+    double E = -R * (ONE - curve_power(T / C, curve, false));
+    return E;
+}
+
+/** @dev calculate_sale_return
+ *  given a token supply, reserve balance, curve and a input amount (in the main token),
+ *  calculates the return for a given conversion (in the reserve token)
+*/
+inline double calculate_sale_return(double balance, double sell_amount, double supply, const curve_coefficients& curve) {
+    double R(supply);
+    double C(balance);
+    double E(sell_amount);
+    double ONE(1.0);
+
+    double T = C * (ONE - curve_power(-E / R, curve, true));
+    return T;
+}
+
+/** @dev calculate_cross_reserve_return
+ *  given the balances and curves of two reserves and a input amount (in the 'from' reserve token),
+ *  calculates the return of a conversion between them (in the 'to' reserve token) without going through the smart token:
+ *  C2 * (1 - (C1 / (C1 + T))^(F1 / F2)), the purchase and the sale combined, so it does not depend on the supply
+*/
+inline double calculate_cross_reserve_return(double from_balance, double deposit_amount, double to_balance, const curve_coefficients& from_curve, const curve_coefficients& to_curve) {
+    double C1(from_balance);
+    double C2(to_balance);
+    double T(deposit_amount);
+    double F(from_curve.purchase_exponent * to_curve.sale_exponent);
+
+    double E = -C2 * expm1(-F * log1p(T / C1));
+    return E;
+}
+
+/** @dev quick_convert
+ *  given two reserves with equal ratios, calculates the return for a given conversion between them (in the 'to' reserve token amount)
+ *  e.g. - quick_convert(1000, 10, 2000) --> 19
+*/
+inline int64_t quick_convert(int64_t balance, int64_t in, int64_t to_balance) {
+    return mul_div(in, to_balance, balance + in);
+}
+
+/** @dev calculate_fee
+ *  returns the fee taken from a return amount, applied once per hop (`magnitude`), rounded up
+ *  e.g. - calculate_fee(10000, 1000, 2) --> 20
+*/
+inline int64_t calculate_fee(int64_t amount, uint64_t fee, uint8_t magnitude) {
+    eosio::check(fee <= MAX_FEE && magnitude <= 2, "invalid fee");
+    const uint64_t max_fee = MAX_FEE;
+    uint128_t denominator = 1;
+    uint128_t remaining = 1;
+    for (uint8_t i = 0; i < magnitude; i++) {
+        denominator *= max_fee;
+        remaining *= max_fee - fee;
+    }
+    return checked_amount(divide(uint128_t(amount) * (denominator - remaining), denominator, rounding_mode::up));
+}
+
+/**
+ * @brief a side of a conversion, either a reserve or the smart token itself
+ */
+struct conversion_side {
+    /**
+     * @brief reserve balance before the conversion, excluding the converted amount, unused for the smart token
+     */
+    int64_t balance;
+
+    /**
+     * @brief precision of the reserve token, or of the smart token
+     */
+    uint8_t precision;
+
+    /**
+     * @brief reserve ratio, 0 for the smart token
+     */
+    uint64_t ratio;
+
+    /**
+     * @brief true for the smart token
+     */
+    bool smart;
+
+    /**
+     * @brief curve coefficients of the reserve, computed from `ratio` when not set
+     */
+    curve_coefficients curve;
+};
+
+/** @dev side_curve
+ *  returns the curve coefficients of a conversion side
+*/
+inline curve_coefficients side_curve(const conversion_side& side) {
+    return side.curve.purchase_exponent > 0 ? side.curve : make_curve_coefficients(side.ratio);
+}
+
+/**
+ * @brief the outcome of a single conversion
+ */
+struct conversion_return {
+    /**
+     * @brief return amount, after the fee
+     */
+    int64_t amount;
+
+    /**
+     * @brief fee amount, in the 'to' token
+     */
+    int64_t fee;
+
+    /**
+     * @brief smart token supply after the conversion, in tokens
+     */
+    double smart_supply;
+};
+
+/** @dev calculate_conversion_return
+ *  converts `amount` of the 'from' token to the 'to' token, conversions between two reserves are computed directly and leave the supply as is,
+ *  `smart_supply` is the smart token supply before the conversion in tokens and `fee` the converter fee
+*/
+inline conversion_return calculate_conversion_return(const conversion_side& from, const conversion_side& to, int64_t amount, double smart_supply, uint64_t fee) {
+    const double from_tokens = amount_to_tokens(amount, from.precision);
+
+    double smart_tokens = 0;
+    int64_t to_amount = 0;
+    bool quick = false;
+
+    if (from.smart) {
+        smart_tokens = from_tokens;
+    }
+    else if (!to.smart && from.ratio == to.ratio) {
+        to_amount = quick_convert(from.balance, amount, to.balance);
+        quick = true;
+    }
+    else if (!to.smart) {
+        const double to_tokens = calculate_cross_reserve_return(amount_to_tokens(from.balance, from.precision), from_tokens, amount_to_tokens(to.balance, to.precision), side_curve(from), side_curve(to));
+        to_amount = tokens_to_amount(to_tokens, to.precision);
+        quick = true;
+    }
+    else {
+        smart_tokens = calculate_purchase_return(amount_to_tokens(from.balance, from.precision), from_tokens, smart_supply, side_curve(from));
+        smart_supply += smart_tokens;
+    }
+
+    if (to.smart) {
+        to_amount = tokens_to_amount(smart_tokens, to.precision);
+    }
+    else if (!quick) {
+        to_amount = tokens_to_amount(calculate_sale_return(amount_to_tokens(to.balance, to.precision), smart_tokens, smart_supply, side_curve(to)), to.precision);
+        smart_supply -= smart_tokens;
+    }
+
+    const uint8_t magnitude = (from.smart || to.smart) ? 1 : 2;
+    const int64_t fee_amount = calculate_fee(to_amount, fee, magnitude);
+    to_amount -= fee_amount;
+
+    if (to.smart)
+        smart_supply -= amount_to_tokens(fee_amount, to.precision);
+
+    return { to_amount, fee_amount, smart_supply };
+}
+
+/** @}*/
@@ -0,0 +1,176 @@
+/**
+ *  @file
+ *  @copyright defined in ../../../LICENSE
+ */
+#pragma once
+
+#include <type_traits>
+#include <eosio/eosio.hpp>
+#include <eosio/asset.hpp>
+#include <eosio/symbol.hpp>
+
+/**
+ * @defgroup CheckFormat Check Format
+ * @brief lazily formatted assertion messages
+ * @details `check_format` only formats its message when the condition fails, into a fixed size buffer on the stack,
+ * so the success path costs a single branch and never allocates
+ * @{
+ */
+
+class message_buffer {
+    public:
+        void append(char c) {
+            if (length < MAX_LENGTH)
+                data[length++] = c;
+        }
+
+        void append(const char* str) {
+            while (*str)
+                append(*str++);
+        }
+
+        void append(uint64_t value) {
+            char digits[20];
+            uint8_t count = 0;
+            do {
+                digits[count++] = '0' + value % 10;
+                value /= 10;
+            } while (value);
+            while (count)
+                append(digits[--count]);
+        }
+
+        void append(int64_t value) {
+            if (value < 0) {
+                append('-');
+                append(uint64_t(0) - uint64_t(value));
+            }
+            else append(uint64_t(value));
+        }
+
+        // prints up to 6 decimals, without trailing zeros
+        void append(double value) {
+            if (value != value) return append("nan");
+            if (value < 0) {
+                append('-');
+                value = -value;
+            }
+            if (value >= 18446744073709551615.0) return append("inf");
+
+            uint64_t integral = value;
+            uint64_t fraction = (value - integral) * 1000000 + 0.5;
+            if (fraction == 1000000) {
+                integral++;
+                fraction = 0;
+            }
+            append(integral);
+            if (fraction == 0) return;
+
+            append('.');
+            for (uint64_t digit = 100000; fraction; digit /= 10) {
+                append(char('0' + fraction / digit));
+                fraction %= digit;
+            }
+        }
+
+        void append(eosio::name value) {
+            static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+            char str[13];
+            uint64_t tmp = value.value;
+            for (uint8_t i = 0; i <= 12; i++) {
+                str[12 - i] = charmap[tmp & (i == 0 ? 0x0f : 0x1f)];
+                tmp >>= (i == 0 ? 4 : 5);
+            }
+            uint8_t end = 13;
+            while (end > 0 && str[end - 1] == '.')
+                end--;
+            for (uint8_t i = 0; i < end; i++)
+                append(str[i]);
+        }
+
+        void append(eosio::symbol_code value) {
+            for (uint64_t sym = value.raw(); sym & 0xFF; sym >>= 8)
+                append(char(sym & 0xFF));
+        }
+
+        void append(const eosio::asset& value) {
+            const uint8_t precision = value.symbol.precision();
+            uint64_t amount = value.amount < 0 ? uint64_t(0) - uint64_t(value.amount) : value.amount;
+            uint64_t factor = 1;
+            for (uint8_t i = 0; i < precision; i++)
+                factor *= 10;
+
+            if (value.amount < 0) append('-');
+            append(amount / factor);
+            if (precision) {
+                append('.');
+                for (uint64_t digit = factor / 10, fraction = amount % factor; digit; digit /= 10) {
+                    append(char('0' + fraction / digit));
+                    fraction %= digit;
+                }
+            }
+            append(' ');
+            append(value.symbol.code());
+        }
+
+        template <typename T>
+        void append_value(const T& value) {
+            if constexpr (std::is_same_v<T, bool>)
+                append(value ? "true" : "false");
+            else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+                append(int64_t(value));
+            else if constexpr (std::is_integral_v<T>)
+                append(uint64_t(value));
+            else if constexpr (std::is_floating_point_v<T>)
+                append(double(value));
+            else if constexpr (std::is_same_v<T, eosio::symbol>)
+                append(value.code());
+            else
+                append(value);
+        }
+
+        const char* c_str() {
+            data[length] = '\0';
+            return data;
+        }
+
+    private:
+        static constexpr uint16_t MAX_LENGTH = 255;
+        char data[MAX_LENGTH + 1];
+        uint16_t length = 0;
+};
+
+inline void format_message(message_buffer& buffer, const char* format) {
+    buffer.append(format);
+}
+
+// replaces each `{}` in the format with the next argument
+template <typename T, typename... Args>
+void format_message(message_buffer& buffer, const char* format, const T& arg, const Args&... args) {
+    for (; *format; format++) {
+        if (format[0] == '{' && format[1] == '}') {
+            buffer.append_value(arg);
+            return format_message(buffer, format + 2, args...);
+        }
+        buffer.append(*format);
+    }
+}
+
+template <typename... Args>
+__attribute__((noinline)) void fail_format(const char* format, const Args&... args) {
+    message_buffer buffer;
+    format_message(buffer, format, args...);
+    eosio::check(false, buffer.c_str());
+}
+
+/** @dev check_format
+ *  asserts the condition, formatting the message only when it fails
+ *  e.g. - check_format(ratio <= MAX_RATIO, "ratio must be between 1 and {}", MAX_RATIO)
+*/
+template <typename... Args>
+inline void check_format(bool pred, const char* format, const Args&... args) {
+    if (!pred)
+        fail_format(format, args...);
+}
+
+/** @}*/
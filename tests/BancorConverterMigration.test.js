@@ -94,6 +94,34 @@ describe('BancorConverterMigration', () => {
             'missing authority'
         )
     })
+    it('ensures BancorConverterMigration::addconverters cannot be called without proper permissions', async () => {
+        const addconverters = api.transact({ 
+            actions: [{
+                account: migrationContract,
+                name: "addconverters",
+                authorization: [{
+                    actor: testAccount1,
+                    permission: 'active',
+                }],
+                data: {
+                    new_converters: [{
+                        sym: 'ABC',
+                        account: 'multi4tokens',
+                        owner: 'bnttestuser1'
+                    }]
+                }
+            }]
+        }, 
+        {
+            blocksBehind: 3,
+            expireSeconds: 30,
+        })
+
+        await expectError(
+            addconverters,
+            'missing authority'
+        )
+    })
     for (const converterToBeMigrated of singleLiquidityProviderMigrations)
         it(`[end2end] single liquidity provider - ${converterToBeMigrated.converter}`, async () => singleLiquidityProviderEndToEnd(converterToBeMigrated))
     
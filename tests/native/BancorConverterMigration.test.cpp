@@ -0,0 +1,598 @@
+#include <numeric>
+#include <random>
+
+#include "fixture.hpp"
+
+namespace {
+
+// the converters of scripts/deploy.sh
+legacy_converter ddd_converter() {
+    return { "bnt2dddcnvrt"_n, "bnt2dddrelay"_n, symbol("BNTDDD", 8), 1000,
+        { { BNT_TOKEN, to_asset("600.00000300 BNT"), 500000 }, { "ddd"_n, to_asset("1201.20000000 DDD"), 500000 } },
+        { { TEST_ACCOUNT_1, to_asset("12000.02009001 BNTDDD") } } };
+}
+
+legacy_converter eee_converter() {
+    return { "bnt2eeecnvrt"_n, "bnt2eeerelay"_n, symbol("BNTEEE", 8), 0,
+        { { BNT_TOKEN, to_asset("702.01000030 BNT"), 500000 }, { "eee"_n, to_asset("6532001.20000000 EEE"), 500000 } },
+        { { TEST_ACCOUNT_1, to_asset("602.03450000 BNTEEE") } } };
+}
+
+legacy_converter ccc_converter() {
+    return { "bnt2ccccnvrt"_n, "bnt2cccrelay"_n, symbol("BNTCCC", 8), 0,
+        { { BNT_TOKEN, to_asset("600.00000300 BNT"), 500000 }, { "ccc"_n, to_asset("1201.20000000 CCC"), 500000 } },
+        { { TEST_ACCOUNT_1, to_asset("90000.00000000 BNTCCC") }, { TEST_ACCOUNT_2, to_asset("10000.00000000 BNTCCC") } } };
+}
+
+legacy_converter fff_converter() {
+    return { "bnt2fffcnvrt"_n, "bnt2fffrelay"_n, symbol("BNTFFF", 8), 1234,
+        { { BNT_TOKEN, to_asset("600.00000300 BNT"), 500000 }, { "fff"_n, to_asset("1201.20000000 FFF"), 500000 } },
+        { { TEST_ACCOUNT_1, to_asset("41316.19284732 BNTFFF") }, { TEST_ACCOUNT_2, to_asset("61693.80915377 BNTFFF") } } };
+}
+
+symbol_code new_pool_token(const legacy_converter& converter) {
+    for (const legacy_reserve& reserve : converter.reserves)
+        if (reserve.balance.symbol.code() != symbol_code("BNT"))
+            return symbol_code(reserve.balance.symbol.code().to_string().substr(0, 4) + "BNT");
+    return symbol_code();
+}
+
+// migrates the holder's pool tokens and asserts that the liquidated reserves end up in the new converter, or back with the holder
+void migrate_and_verify(bancor_chain& chain, const legacy_converter& converter, name holder) {
+    const symbol_code new_sym = new_pool_token(converter);
+    const bool converter_existed = chain.has_converter(new_sym);
+
+    vector<int64_t> old_balances, new_balances, holder_balances;
+    for (const legacy_reserve& reserve : converter.reserves) {
+        const symbol_code sym = reserve.balance.symbol.code();
+        old_balances.push_back(chain.balance(reserve.contract, converter.account, sym));
+        new_balances.push_back(chain.reserve_balance(new_sym, sym));
+        holder_balances.push_back(chain.balance(reserve.contract, holder, sym));
+    }
+    const int64_t pool_tokens = chain.balance(converter.relay, holder, converter.relay_symbol.code());
+    const int64_t new_pool_tokens = chain.balance(MULTI_TOKEN, holder, new_sym);
+
+    chain.push_action(converter.relay, "transfer"_n, holder, holder, MIGRATION, asset(pool_tokens, converter.relay_symbol), "");
+
+    for (size_t i = 0; i < converter.reserves.size(); i++) {
+        const legacy_reserve& reserve = converter.reserves[i];
+        const symbol_code sym = reserve.balance.symbol.code();
+        const int64_t liquidated = old_balances[i] - chain.balance(reserve.contract, converter.account, sym);
+        const int64_t funded = chain.reserve_balance(new_sym, sym) - new_balances[i];
+        const int64_t refunded = chain.balance(reserve.contract, holder, sym) - holder_balances[i];
+
+        EXPECT_GT(liquidated, 0) << sym.to_string();
+        EXPECT_EQ(liquidated, funded + refunded) << sym.to_string();
+        if (!converter_existed)
+            EXPECT_EQ(refunded, 0) << sym.to_string();
+        EXPECT_EQ(chain.balance(reserve.contract, MIGRATION, sym), 0) << sym.to_string();
+    }
+
+    EXPECT_EQ(chain.balance(converter.relay, holder, converter.relay_symbol.code()), 0);
+    EXPECT_EQ(chain.balance(converter.relay, MIGRATION, converter.relay_symbol.code()), 0);
+    EXPECT_GT(chain.balance(MULTI_TOKEN, holder, new_sym), new_pool_tokens);
+    EXPECT_EQ(chain.balance(MULTI_TOKEN, MIGRATION, new_sym), 0);
+
+    BancorConverterMigration::migrations migrations_table(MIGRATION, MIGRATION.value);
+    EXPECT_FALSE(migrations_table.exists());
+}
+
+} // namespace
+
+TEST(BancorConverterMigration, addconverter_requires_permissions) {
+    bancor_chain chain;
+    expect_assert([&] {
+        chain.push_action(MIGRATION, "addconverter"_n, TEST_ACCOUNT_1, symbol_code("BNTEEE"), "bnt2eeecnvrt"_n, TEST_ACCOUNT_1);
+    }, "missing authority");
+}
+
+TEST(BancorConverterMigration, delconverter_requires_permissions) {
+    bancor_chain chain;
+    chain.add_legacy_converter(eee_converter());
+    expect_assert([&] {
+        chain.push_action(MIGRATION, "delconverter"_n, TEST_ACCOUNT_1, symbol_code("BNTEEE"));
+    }, "missing authority");
+}
+
+TEST(BancorConverterMigration, addconverters_requires_permissions) {
+    bancor_chain chain;
+    const vector<BancorConverterMigration::converter_entry> converters = { { symbol_code("ABC"), "multi4tokens"_n, TEST_ACCOUNT_1 } };
+    expect_assert([&] {
+        chain.push_action(MIGRATION, "addconverters"_n, TEST_ACCOUNT_1, converters);
+    }, "missing authority");
+}
+
+TEST(BancorConverterMigration, rejects_duplicate_converter_accounts) {
+    bancor_chain chain;
+    chain.add_legacy_converter(eee_converter());
+    expect_assert([&] {
+        chain.push_action(MIGRATION, "addconverter"_n, MIGRATION, symbol_code("BNTXYZ"), "bnt2eeecnvrt"_n, TEST_ACCOUNT_1);
+    }, "is already registered");
+}
+
+TEST(BancorConverterMigration, moves_registry_rows_from_the_former_scopes) {
+    bancor_chain chain;
+    const legacy_converter converter = eee_converter();
+    const symbol_code BNTEEE = converter.relay_symbol.code();
+    chain.add_legacy_converter(converter);
+    chain.push_action(MIGRATION, "delconverter"_n, MIGRATION, BNTEEE);
+
+    // as registered before the registry was kept in a single scope
+    BancorConverterMigration::converters former_converters_table(MIGRATION, BNTEEE.raw());
+    former_converters_table.emplace(MIGRATION, [&](auto& c) {
+        c.sym = BNTEEE;
+        c.account = converter.account;
+        c.owner = TEST_ACCOUNT_1;
+    });
+
+    expect_assert([&] { chain.push_action(MIGRATION, "rescope"_n, TEST_ACCOUNT_1, vector<symbol_code>{ BNTEEE }); }, "missing authority");
+    expect_assert([&] {
+        chain.push_action(MIGRATION, "rescope"_n, MIGRATION, vector<symbol_code>{ BNTEEE, symbol_code("BNTDDD") });
+    }, "converter_currency wasn't found");
+
+    chain.push_action(MIGRATION, "rescope"_n, MIGRATION, vector<symbol_code>{ BNTEEE });
+    EXPECT_EQ(former_converters_table.find(BNTEEE.raw()), former_converters_table.end());
+    const BancorConverterMigration::converters converters_table(MIGRATION, MIGRATION.value);
+    const BancorConverterMigration::converter_t& row = converters_table.get(BNTEEE.raw());
+    EXPECT_EQ(row.account, converter.account);
+    EXPECT_EQ(row.owner, TEST_ACCOUNT_1);
+    EXPECT_EQ(row.new_pool_token.value(), new_pool_token(converter));
+
+    migrate_and_verify(chain, converter, TEST_ACCOUNT_1);
+}
+
+TEST(BancorConverterMigration, rejects_unregistered_pool_tokens) {
+    bancor_chain chain;
+    legacy_converter converter = eee_converter();
+    chain.add_legacy_converter(converter);
+    chain.push_action(MIGRATION, "delconverter"_n, MIGRATION, converter.relay_symbol.code());
+
+    expect_assert([&] {
+        chain.push_action(converter.relay, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, MIGRATION, to_asset("1.00000000 BNTEEE"), "");
+    }, "converter_currency wasn't found");
+    EXPECT_EQ(chain.balance(converter.relay, TEST_ACCOUNT_1, converter.relay_symbol.code()), to_asset("602.03450000 BNTEEE").amount);
+}
+
+TEST(BancorConverterMigration, rejects_accounts_hosting_several_pools) {
+    bancor_chain chain;
+    const legacy_converter ddd = ddd_converter();
+    chain.add_hosted_pool(ddd);
+    expect_assert([&] {
+        chain.push_action(MIGRATION, "addconverter"_n, MIGRATION, ddd.relay_symbol.code(), ddd.account, TEST_ACCOUNT_1);
+    }, "converter account bnt2dddcnvrt hosts several pools, which cannot be migrated");
+
+    // registered before the account started hosting pools
+    const legacy_converter eee = eee_converter();
+    chain.push_action(MIGRATION, "addconverter"_n, MIGRATION, eee.relay_symbol.code(), eee.account, TEST_ACCOUNT_1);
+    chain.add_hosted_pool(eee);
+    expect_assert([&] {
+        chain.push_action(MIGRATION, "previewmig"_n, TEST_ACCOUNT_1, to_asset("1.00000000 BNTEEE"));
+    }, "hosts several pools");
+    expect_assert([&] {
+        chain.push_action(eee.relay, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, MIGRATION, to_asset("1.00000000 BNTEEE"), "");
+    }, "hosts several pools");
+}
+
+TEST(BancorConverterMigration, single_liquidity_provider) {
+    for (const legacy_converter& converter : { ddd_converter(), eee_converter() }) {
+        bancor_chain chain;
+        chain.add_legacy_converter(converter);
+        migrate_and_verify(chain, converter, TEST_ACCOUNT_1);
+
+        const symbol_code new_sym = new_pool_token(converter);
+        for (const legacy_reserve& reserve : converter.reserves)
+            EXPECT_EQ(chain.reserve_balance(new_sym, reserve.balance.symbol.code()), reserve.balance.amount);
+
+        const BancorConverter::converter_t new_converter = chain.new_converter(new_sym);
+        EXPECT_EQ(new_converter.fee, converter.fee);
+        EXPECT_EQ(new_converter.owner, TEST_ACCOUNT_1);
+        EXPECT_EQ(chain.supply(MULTI_TOKEN, new_sym), chain.balance(MULTI_TOKEN, TEST_ACCOUNT_1, new_sym));
+        EXPECT_EQ(chain.legacy_settings(converter.account).fee, converter.fee);
+    }
+}
+
+TEST(BancorConverterMigration, multiple_liquidity_providers) {
+    for (const legacy_converter& converter : { ccc_converter(), fff_converter() }) {
+        bancor_chain chain;
+        chain.add_legacy_converter(converter);
+        migrate_and_verify(chain, converter, TEST_ACCOUNT_1);
+        migrate_and_verify(chain, converter, TEST_ACCOUNT_2);
+
+        const symbol_code new_sym = new_pool_token(converter);
+        EXPECT_EQ(chain.new_converter(new_sym).owner, TEST_ACCOUNT_1);
+        EXPECT_EQ(chain.supply(MULTI_TOKEN, new_sym),
+            chain.balance(MULTI_TOKEN, TEST_ACCOUNT_1, new_sym) + chain.balance(MULTI_TOKEN, TEST_ACCOUNT_2, new_sym));
+        EXPECT_EQ(chain.supply(converter.relay, converter.relay_symbol.code()), 0);
+    }
+}
+
+TEST(BancorConverterMigration, refunds_reserves_without_scanning_other_balances) {
+    const legacy_converter converter = ccc_converter();
+    uint64_t accounts_reads = 0;
+    {
+        bancor_chain chain;
+        chain.add_legacy_converter(converter);
+        migrate_and_verify(chain, converter, TEST_ACCOUNT_1);
+        migrate_and_verify(chain, converter, TEST_ACCOUNT_2);
+        accounts_reads = chain.db_reads(MIGRATION, "accounts"_n);
+    }
+
+    bancor_chain chain;
+    chain.add_legacy_converter(converter);
+    migrate_and_verify(chain, converter, TEST_ACCOUNT_1);
+    // temporary balances of the migration contract in other converters
+    BancorConverter::accounts accounts_table(MULTI_CONVERTER, MIGRATION.value);
+    for (uint64_t i = 0; i < 50; i++)
+        accounts_table.emplace(MIGRATION, [&](auto& a) {
+            a.symbl = symbol_code("XYZBNT");
+            a.quantity = asset(1, symbol(symbol_code("BNT"), 8));
+            a.id = 1000 + i;
+        });
+    migrate_and_verify(chain, converter, TEST_ACCOUNT_2);
+    EXPECT_EQ(chain.db_reads(MIGRATION, "accounts"_n), accounts_reads);
+}
+
+TEST(BancorConverterMigration, single_reserve_converters_liquidate_the_whole_balance) {
+    bancor_chain chain;
+    const legacy_converter converter = { "bnt2hhhcnvrt"_n, "bnt2hhhrelay"_n, symbol("BNTHHH", 8), 1000,
+        { { "hhh"_n, to_asset("1000.0000 HHH"), 1000000 } },
+        { { TEST_ACCOUNT_1, to_asset("500.00000000 BNTHHH") } } };
+    chain.add_legacy_converter(converter);
+    migrate_and_verify(chain, converter, TEST_ACCOUNT_1);
+
+    EXPECT_EQ(chain.balance("hhh"_n, converter.account, symbol_code("HHH")), 0);
+    EXPECT_EQ(chain.reserve_balance(new_pool_token(converter), symbol_code("HHH")), to_asset("1000.0000 HHH").amount);
+}
+
+TEST(BancorConverterMigration, partial_weights_liquidate_the_same_share_of_each_reserve) {
+    bancor_chain chain;
+    const legacy_converter converter = { "bnt2iiicnvrt"_n, "bnt2iiirelay"_n, symbol("BNTIII", 8), 1000,
+        { { BNT_TOKEN, to_asset("600.00000300 BNT"), 250000 }, { "iii"_n, to_asset("1201.20000000 III"), 250000 } },
+        { { TEST_ACCOUNT_1, to_asset("3000.00000000 BNTIII") }, { TEST_ACCOUNT_2, to_asset("7000.00000000 BNTIII") } } };
+    chain.add_legacy_converter(converter);
+    migrate_and_verify(chain, converter, TEST_ACCOUNT_1);
+
+    // the weights add up to 50%, selling 30% of the supply returns 1 - 0.7^2 of each reserve
+    for (const legacy_reserve& reserve : converter.reserves) {
+        const int64_t left = chain.balance(reserve.contract, converter.account, reserve.balance.symbol.code());
+        EXPECT_NEAR(1.0 - double(left) / reserve.balance.amount, 1.0 - pow(0.7, 2), 1e-8) << reserve.balance.symbol.code().to_string();
+    }
+
+    migrate_and_verify(chain, converter, TEST_ACCOUNT_2);
+    EXPECT_EQ(chain.supply(converter.relay, converter.relay_symbol.code()), 0);
+}
+
+TEST(BancorConverterMigration, randomized_migrations) {
+    std::mt19937_64 random(20201019);
+    const vector<name> reserve_accounts = { "aaa"_n, "bbb"_n };
+    const vector<string> reserve_symbols = { "AAA", "BBB" };
+
+    for (int run = 0; run < 200; run++) {
+        SCOPED_TRACE("run " + std::to_string(run));
+        std::uniform_int_distribution<int64_t> amount(10000000000, 100000000000000);
+
+        legacy_converter converter = { "bnt2xyzcnvrt"_n, "bnt2xyzrelay"_n, symbol("BNTXYZ", 8), uint64_t(random() % 30001), {}, {} };
+        const size_t reserves_count = 2 + random() % 2;
+        uint64_t remaining_ratio = 1000000;
+        for (size_t i = 0; i < reserves_count; i++) {
+            const uint64_t ratio = i + 1 == reserves_count ? remaining_ratio : 100000 + random() % (remaining_ratio - 100000 * (reserves_count - i));
+            remaining_ratio -= ratio;
+            if (i == 0)
+                converter.reserves.push_back({ BNT_TOKEN, asset(amount(random), symbol("BNT", 8)), ratio });
+            else
+                converter.reserves.push_back({ reserve_accounts[i - 1], asset(amount(random), symbol(reserve_symbols[i - 1], 4 + random() % 5)), ratio });
+        }
+        converter.holders.push_back({ TEST_ACCOUNT_1, asset(amount(random), converter.relay_symbol) });
+        if (random() % 2)
+            converter.holders.push_back({ TEST_ACCOUNT_2, asset(amount(random), converter.relay_symbol) });
+
+        bancor_chain chain;
+        chain.add_legacy_converter(converter);
+        for (const auto& [holder, pool_tokens] : converter.holders)
+            migrate_and_verify(chain, converter, holder);
+    }
+}
+
+namespace {
+
+// the value of the next `key` of an event printed to the console, from `pos` on
+string event_value(const string& console, const string& key, size_t& pos) {
+    pos = console.find("\"" + key + "\":\"", pos);
+    EXPECT_NE(pos, string::npos) << key;
+    pos += key.size() + 4;
+    return console.substr(pos, console.find('"', pos) - pos);
+}
+
+} // namespace
+
+TEST(BancorConverterMigration, previews_migrations) {
+    for (const legacy_converter& converter : { ccc_converter(), fff_converter() }) {
+        SCOPED_TRACE(converter.account.to_string());
+        bancor_chain chain;
+        chain.add_legacy_converter(converter);
+        const symbol_code new_sym = new_pool_token(converter);
+
+        // the first holder creates the new converter, the second funds it
+        for (const name holder : { TEST_ACCOUNT_1, TEST_ACCOUNT_2 }) {
+            const asset pool_tokens(chain.balance(converter.relay, holder, converter.relay_symbol.code()), converter.relay_symbol);
+            chain.push_action(MIGRATION, "previewmig"_n, TEST_ACCOUNT_2, pool_tokens);
+            EXPECT_EQ(chain.executed_actions().size(), 1);
+            const string console = chain.console();
+
+            size_t pos = 0;
+            EXPECT_EQ(event_value(console, "etype", pos), "migration_preview");
+            EXPECT_EQ(event_value(console, "new_pool_token", pos), new_sym.to_string());
+            EXPECT_EQ(event_value(console, "converter_exists", pos), holder == TEST_ACCOUNT_1 ? "false" : "true");
+
+            // in the order of the reserves table
+            vector<legacy_reserve> reserves;
+            vector<int64_t> balances, liquidation_amounts, returns;
+            for (size_t i = 0; i < converter.reserves.size(); i++) {
+                const string sym = event_value(console, "symbol", pos);
+                const legacy_reserve& reserve = *std::find_if(converter.reserves.begin(), converter.reserves.end(), [&](const legacy_reserve& r) {
+                    return r.balance.symbol.code().to_string() == sym;
+                });
+                reserves.push_back(reserve);
+                balances.push_back(chain.balance(reserve.contract, converter.account, reserve.balance.symbol.code()));
+                liquidation_amounts.push_back(tokens_to_amount(std::stod(event_value(console, "liquidation_amount", pos)), 8, rounding_mode::nearest));
+                returns.push_back(tokens_to_amount(std::stod(event_value(console, "return", pos)), reserve.balance.symbol.precision(), rounding_mode::nearest));
+            }
+            const double new_pool_tokens = std::stod(event_value(console, "new_pool_tokens", pos));
+            EXPECT_EQ(std::accumulate(liquidation_amounts.begin(), liquidation_amounts.end(), int64_t(0)), pool_tokens.amount);
+
+            const int64_t new_balance = chain.balance(MULTI_TOKEN, holder, new_sym);
+            chain.push_action(converter.relay, "transfer"_n, holder, holder, MIGRATION, pool_tokens, "");
+            for (size_t i = 0; i < reserves.size(); i++) {
+                const legacy_reserve& reserve = reserves[i];
+                EXPECT_EQ(balances[i] - chain.balance(reserve.contract, converter.account, reserve.balance.symbol.code()), returns[i]) << reserve.balance.to_string();
+            }
+            EXPECT_EQ(tokens_to_amount(new_pool_tokens, 4, rounding_mode::nearest), chain.balance(MULTI_TOKEN, holder, new_sym) - new_balance);
+        }
+    }
+}
+
+TEST(BancorConverterMigration, previewmig_rejects_unknown_pool_tokens) {
+    bancor_chain chain;
+    chain.add_legacy_converter(eee_converter());
+    expect_assert([&] { chain.push_action(MIGRATION, "previewmig"_n, TEST_ACCOUNT_1, to_asset("1.0000 BNTXYZ")); }, "converter not found");
+    expect_assert([&] { chain.push_action(MIGRATION, "previewmig"_n, TEST_ACCOUNT_1, to_asset("0.00000000 BNTEEE")); }, "invalid quantity");
+}
+
+namespace {
+
+// the balances a migration changes
+vector<int64_t> migration_state(bancor_chain& chain, const legacy_converter& converter) {
+    const symbol_code new_sym = new_pool_token(converter);
+    vector<int64_t> state = { chain.supply(MULTI_TOKEN, new_sym), chain.supply(converter.relay, converter.relay_symbol.code()) };
+    for (const auto& [holder, pool_tokens] : converter.holders)
+        state.push_back(chain.balance(MULTI_TOKEN, holder, new_sym));
+    for (const legacy_reserve& reserve : converter.reserves) {
+        const symbol_code sym = reserve.balance.symbol.code();
+        state.push_back(chain.reserve_balance(new_sym, sym));
+        state.push_back(chain.balance(reserve.contract, converter.account, sym));
+        for (const auto& [holder, pool_tokens] : converter.holders)
+            state.push_back(chain.balance(reserve.contract, holder, sym));
+    }
+    return state;
+}
+
+// migrates all of the holder's pool tokens in steps, returns the number of steps
+size_t migrate_in_steps(bancor_chain& chain, const legacy_converter& converter, name holder) {
+    const asset pool_tokens(chain.balance(converter.relay, holder, converter.relay_symbol.code()), converter.relay_symbol);
+    chain.push_action(converter.relay, "transfer"_n, holder, holder, MIGRATION, pool_tokens, "chunked");
+    EXPECT_EQ(chain.executed_actions().size(), 1);
+
+    const BancorConverterMigration::chunked_migrations chunked_migrations_table(MIGRATION, MIGRATION.value);
+    size_t steps = 0;
+    while (chunked_migrations_table.find(converter.relay_symbol.code().raw()) != chunked_migrations_table.end()) {
+        chain.push_action(MIGRATION, "migstep"_n, holder, converter.relay_symbol.code());
+        // the fee is only disabled within the liquidation step
+        EXPECT_EQ(chain.legacy_settings(converter.account).fee, converter.fee);
+        EXPECT_LE(chain.executed_actions().size(), 32);
+        steps++;
+    }
+    BancorConverterMigration::migrations migrations_table(MIGRATION, MIGRATION.value);
+    EXPECT_FALSE(migrations_table.exists());
+    return steps;
+}
+
+} // namespace
+
+TEST(BancorConverterMigration, chunked_migrations_match_single_transaction_migrations) {
+    for (const legacy_converter& converter : { ccc_converter(), fff_converter() }) {
+        SCOPED_TRACE(converter.account.to_string());
+        vector<int64_t> expected;
+        {
+            bancor_chain chain;
+            chain.add_legacy_converter(converter);
+            for (const auto& [holder, pool_tokens] : converter.holders)
+                migrate_and_verify(chain, converter, holder);
+            expected = migration_state(chain, converter);
+        }
+
+        bancor_chain chain;
+        chain.add_legacy_converter(converter);
+        // creation, a reserve per step, then the liquidations and the funding, only the last step once the new converter exists
+        EXPECT_EQ(migrate_in_steps(chain, converter, TEST_ACCOUNT_1), 1 + 2 + 1);
+        EXPECT_EQ(migrate_in_steps(chain, converter, TEST_ACCOUNT_2), 1);
+        EXPECT_EQ(migration_state(chain, converter), expected);
+        EXPECT_EQ(chain.balance(converter.relay, MIGRATION, converter.relay_symbol.code()), 0);
+    }
+}
+
+TEST(BancorConverterMigration, chunked_migrations_only_hold_their_converters) {
+    bancor_chain chain;
+    const legacy_converter converter = ccc_converter();
+    chain.add_legacy_converter(converter);
+    chain.add_legacy_converter(eee_converter());
+    const symbol_code BNTCCC = converter.relay_symbol.code();
+
+    chain.push_action(converter.relay, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, MIGRATION, to_asset("100.00000000 BNTCCC"), "chunked");
+    expect_assert([&] { chain.push_action(MIGRATION, "migstep"_n, TEST_ACCOUNT_2, BNTCCC); }, "missing authority");
+    expect_assert([&] { chain.push_action(MIGRATION, "migstep"_n, TEST_ACCOUNT_1, symbol_code("BNTEEE")); }, "no chunked migration of this converter");
+    expect_assert([&] {
+        chain.push_action(converter.relay, "transfer"_n, TEST_ACCOUNT_2, TEST_ACCOUNT_2, MIGRATION, to_asset("1.00000000 BNTCCC"), "");
+    }, "a chunked migration of BNTCCC is in progress");
+    expect_assert([&] { chain.push_action(MIGRATION, "delconverter"_n, MIGRATION, BNTCCC); }, "a chunked migration of BNTCCC is in progress");
+
+    // other converters migrate between the steps
+    chain.push_action(MIGRATION, "migstep"_n, TEST_ACCOUNT_1, BNTCCC);
+    migrate_and_verify(chain, eee_converter(), TEST_ACCOUNT_1);
+    chain.push_action(MIGRATION, "migstep"_n, TEST_ACCOUNT_1, BNTCCC);
+    chain.push_action(MIGRATION, "migstep"_n, TEST_ACCOUNT_1, BNTCCC);
+    EXPECT_EQ(chain.balance(MULTI_TOKEN, TEST_ACCOUNT_1, new_pool_token(converter)), 0);
+
+    chain.push_action(MIGRATION, "migstep"_n, TEST_ACCOUNT_1, BNTCCC);
+    EXPECT_GT(chain.balance(MULTI_TOKEN, TEST_ACCOUNT_1, new_pool_token(converter)), 0);
+    EXPECT_EQ(chain.balance(converter.relay, MIGRATION, BNTCCC), 0);
+    expect_assert([&] { chain.push_action(MIGRATION, "migstep"_n, TEST_ACCOUNT_1, BNTCCC); }, "no chunked migration of this converter");
+}
+
+TEST(BancorConverterMigration, chunked_migrations_follow_the_reserves_they_started_with) {
+    bancor_chain chain;
+    const legacy_converter converter = ccc_converter();
+    chain.add_legacy_converter(converter);
+    const symbol_code BNTCCC = converter.relay_symbol.code();
+    const int64_t balance = chain.balance(converter.relay, TEST_ACCOUNT_1, BNTCCC);
+
+    chain.push_action(converter.relay, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, MIGRATION, to_asset("100.00000000 BNTCCC"), "chunked");
+    chain.push_action(MIGRATION, "migstep"_n, TEST_ACCOUNT_1, BNTCCC);
+
+    // a reserve added to the old converter between the steps
+    LegacyBancorConverter::reserves reserves_table(converter.account, converter.account.value);
+    reserves_table.emplace(converter.account, [&](auto& r) {
+        r.contract = "ddd"_n;
+        r.currency = asset(0, symbol("DDD", 8));
+        r.ratio = 0;
+    });
+    expect_assert([&] { chain.push_action(MIGRATION, "migstep"_n, TEST_ACCOUNT_1, BNTCCC); }, "the reserves of the converter changed");
+
+    chain.push_action(MIGRATION, "cancelmig"_n, TEST_ACCOUNT_1, BNTCCC);
+    EXPECT_EQ(chain.balance(converter.relay, TEST_ACCOUNT_1, BNTCCC), balance);
+}
+
+TEST(BancorConverterMigration, chunked_migrations_hold_their_new_pool_token) {
+    bancor_chain chain;
+    const legacy_converter converter = eee_converter();
+    chain.add_legacy_converter(converter);
+
+    // a chunked migration of another converter to the same new pool token
+    BancorConverterMigration::chunked_migrations chunked_migrations_table(MIGRATION, MIGRATION.value);
+    chunked_migrations_table.emplace(MIGRATION, [&](auto& m) {
+        m.old_pool_token = symbol("BNTXYZ", 8);
+        m.new_pool_token = new_pool_token(converter);
+        m.migration_initiator = TEST_ACCOUNT_2;
+        m.cursor.emplace(BancorConverterMigration::migration_cursor{ 1, 0 });
+    });
+    expect_assert([&] {
+        chain.push_action(converter.relay, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, MIGRATION, to_asset("1.00000000 BNTEEE"), "");
+    }, "a chunked migration to EEEBNT is in progress");
+}
+
+TEST(BancorConverterMigration, cancels_chunked_migrations) {
+    const legacy_converter converter = ccc_converter();
+    const symbol_code BNTCCC = converter.relay_symbol.code();
+    const symbol_code CCCBNT = new_pool_token(converter);
+    const int64_t pool_tokens = to_asset("100.00000000 BNTCCC").amount;
+    {
+        // by the initiator before the new converter is created
+        bancor_chain chain;
+        chain.add_legacy_converter(converter);
+        const int64_t balance = chain.balance(converter.relay, TEST_ACCOUNT_1, BNTCCC);
+        chain.push_action(converter.relay, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, MIGRATION, asset(pool_tokens, converter.relay_symbol), "chunked");
+        expect_assert([&] { chain.push_action(MIGRATION, "cancelmig"_n, TEST_ACCOUNT_2, BNTCCC); }, "missing authority to cancel");
+        chain.push_action(MIGRATION, "cancelmig"_n, TEST_ACCOUNT_1, BNTCCC);
+        EXPECT_EQ(chain.balance(converter.relay, TEST_ACCOUNT_1, BNTCCC), balance);
+        EXPECT_FALSE(chain.has_converter(CCCBNT));
+        expect_assert([&] { chain.push_action(MIGRATION, "cancelmig"_n, TEST_ACCOUNT_1, BNTCCC); }, "no chunked migration of this converter");
+        migrate_and_verify(chain, converter, TEST_ACCOUNT_1);
+    }
+
+    // by anyone once it was not advanced before its deadline, the new converter goes to the converter owner
+    bancor_chain chain;
+    chain.add_legacy_converter(converter);
+    const int64_t balance = chain.balance(converter.relay, TEST_ACCOUNT_1, BNTCCC);
+    chain.set_time(1600000000);
+    chain.push_action(converter.relay, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, MIGRATION, asset(pool_tokens, converter.relay_symbol), "chunked");
+    chain.push_action(MIGRATION, "migstep"_n, TEST_ACCOUNT_1, BNTCCC);
+    chain.set_time(1600000000 + 60);
+    chain.push_action(MIGRATION, "migstep"_n, TEST_ACCOUNT_1, BNTCCC);
+
+    chain.set_time(1600000000 + 60 + 24 * 60 * 60 - 1);
+    expect_assert([&] { chain.push_action(MIGRATION, "cancelmig"_n, TEST_ACCOUNT_2, BNTCCC); }, "missing authority to cancel");
+    chain.set_time(1600000000 + 60 + 24 * 60 * 60);
+    chain.push_action(MIGRATION, "cancelmig"_n, TEST_ACCOUNT_2, BNTCCC);
+
+    EXPECT_EQ(chain.balance(converter.relay, TEST_ACCOUNT_1, BNTCCC), balance);
+    EXPECT_EQ(chain.balance(converter.relay, MIGRATION, BNTCCC), 0);
+    const BancorConverter::converters new_converters_table(MULTI_CONVERTER, CCCBNT.raw());
+    EXPECT_EQ(new_converters_table.get(CCCBNT.raw()).owner, TEST_ACCOUNT_1);
+    EXPECT_EQ(chain.balance(MULTI_TOKEN, TEST_ACCOUNT_1, CCCBNT), chain.supply(MULTI_TOKEN, CCCBNT));
+    EXPECT_EQ(chain.balance(MULTI_TOKEN, MIGRATION, CCCBNT), 0);
+}
+
+TEST(BancorConverterMigration, stores_the_new_pool_token_on_registration) {
+    bancor_chain chain;
+    const legacy_converter ggggg_converter = { "bnt2gggcnvrt"_n, "bnt2gggrelay"_n, symbol("BNTGGG", 8), 0,
+        { { BNT_TOKEN, to_asset("600.00000300 BNT"), 500000 }, { "ggggg"_n, to_asset("1201.2000 GGGGG"), 500000 } },
+        { { TEST_ACCOUNT_1, to_asset("1000.00000000 BNTGGG") } } };
+    chain.add_legacy_converter(ccc_converter());
+    chain.add_legacy_converter(ggggg_converter);
+    chain.push_action(MIGRATION, "addconverter"_n, MIGRATION, symbol_code("BNTXYZ"), MULTI_TOKEN, TEST_ACCOUNT_1);
+
+    const BancorConverterMigration::converters converters_table(MIGRATION, MIGRATION.value);
+    EXPECT_EQ(converters_table.get(symbol_code("BNTCCC").raw()).new_pool_token.value().to_string(), "CCCBNT");
+    EXPECT_EQ(converters_table.get(symbol_code("BNTGGG").raw()).new_pool_token.value().to_string(), "GGGGBNT");
+    EXPECT_EQ(new_pool_token(ggggg_converter).to_string(), "GGGGBNT");
+    EXPECT_EQ(converters_table.get(symbol_code("BNTCCC").raw()).reserves_count.value(), 2);
+
+    // registered before it had any reserve
+    EXPECT_FALSE(converters_table.get(symbol_code("BNTXYZ").raw()).new_pool_token.has_value());
+    EXPECT_FALSE(converters_table.get(symbol_code("BNTXYZ").raw()).reserves_count.has_value());
+    expect_assert([&] { chain.push_action(MIGRATION, "refreshsym"_n, MIGRATION, symbol_code("BNTXYZ")); }, "couldn't find reserve code");
+    expect_assert([&] { chain.push_action(MIGRATION, "refreshsym"_n, TEST_ACCOUNT_1, symbol_code("BNTCCC")); }, "missing authority");
+
+    // counted before a reserve was added to the old converter
+    BancorConverterMigration::converters writable_converters_table(MIGRATION, MIGRATION.value);
+    writable_converters_table.modify(writable_converters_table.get(symbol_code("BNTCCC").raw()), MIGRATION, [](auto& c) { c.reserves_count.emplace(1); });
+    expect_assert([&] {
+        chain.push_action(ccc_converter().relay, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, MIGRATION, to_asset("1.00000000 BNTCCC"), "");
+    }, "the reserves of the converter changed since its registration");
+    chain.push_action(MIGRATION, "refreshsym"_n, MIGRATION, symbol_code("BNTCCC"));
+    EXPECT_EQ(converters_table.get(symbol_code("BNTCCC").raw()).reserves_count.value(), 2);
+    migrate_and_verify(chain, ccc_converter(), TEST_ACCOUNT_1);
+}
+
+TEST(BancorConverterMigration, migrates_registry_rows_without_the_new_pool_token) {
+    const legacy_converter converter = ccc_converter();
+    const symbol_code BNTCCC = converter.relay_symbol.code();
+    vector<int64_t> expected;
+    uint64_t reserve_reads = 0;
+    {
+        bancor_chain chain;
+        chain.add_legacy_converter(converter);
+        migrate_and_verify(chain, converter, TEST_ACCOUNT_1);
+        reserve_reads = chain.db_reads(MIGRATION, "reserves"_n);
+        EXPECT_EQ(chain.db_reads(MIGRATION, "pools"_n), 0);
+        expected = migration_state(chain, converter);
+    }
+
+    bancor_chain chain;
+    chain.add_legacy_converter(converter);
+    // as written before the registry held the new pool token
+    BancorConverterMigration::converters converters_table(MIGRATION, MIGRATION.value);
+    converters_table.modify(converters_table.get(BNTCCC.raw()), MIGRATION, [](auto& c) {
+        c.reserves_count.reset();
+        c.new_pool_token.reset();
+    });
+
+    migrate_and_verify(chain, converter, TEST_ACCOUNT_1);
+    // the new pool token and the reserves count are read from the old converter again, which is checked for hosted pools
+    EXPECT_GT(chain.db_reads(MIGRATION, "reserves"_n), reserve_reads);
+    EXPECT_GT(chain.db_reads(MIGRATION, "pools"_n), 0);
+    EXPECT_EQ(migration_state(chain, converter), expected);
+
+    chain.push_action(MIGRATION, "refreshsym"_n, MIGRATION, BNTCCC);
+    EXPECT_EQ(converters_table.get(BNTCCC.raw()).new_pool_token.value(), new_pool_token(converter));
+    EXPECT_EQ(converters_table.get(BNTCCC.raw()).reserves_count.value(), 2);
+}
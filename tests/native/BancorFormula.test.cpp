@@ -0,0 +1,109 @@
+#include <random>
+
+#include "fixture.hpp"
+
+TEST(BancorFormula, classifies_curve_kernels) {
+    EXPECT_EQ(make_curve_coefficients(1000000).kernel, uint8_t(curve_kernel::linear));
+    EXPECT_EQ(make_curve_coefficients(500000).kernel, uint8_t(curve_kernel::square_root));
+
+    const curve_coefficients curve = make_curve_coefficients(250000);
+    EXPECT_EQ(curve.kernel, uint8_t(curve_kernel::generic));
+    EXPECT_EQ(curve.purchase_exponent, 0.25);
+    EXPECT_EQ(curve.sale_exponent, 4.0);
+
+    expect_assert([] { make_curve_coefficients(0); }, "invalid ratio");
+    expect_assert([] { make_curve_coefficients(1000001); }, "invalid ratio");
+}
+
+TEST(BancorFormula, kernels_match_pow) {
+    std::mt19937_64 random(20201019);
+    std::uniform_real_distribution<double> share(0, 1);
+    for (uint64_t ratio : { 1000000, 500000, 1, 100000, 333333, 700000, 999999 }) {
+        const curve_coefficients curve = make_curve_coefficients(ratio);
+        for (int i = 0; i < 10000; i++) {
+            const double x = share(random) * share(random);
+            const double purchase = pow(1.0 + x, ratio / MAX_RATIO);
+            const double sale = pow(1.0 - x, MAX_RATIO / ratio);
+            if (curve.kernel == uint8_t(curve_kernel::generic)) {
+                EXPECT_EQ(curve_power(x, curve, false), purchase) << ratio << " " << x;
+                EXPECT_EQ(curve_power(-x, curve, true), sale) << ratio << " " << x;
+                continue;
+            }
+            EXPECT_NEAR(curve_power(x, curve, false), purchase, purchase * 1e-15) << ratio << " " << x;
+            EXPECT_NEAR(curve_power(-x, curve, true), sale, sale * 1e-15) << ratio << " " << x;
+        }
+    }
+}
+
+TEST(BancorFormula, computes_missing_coefficients_from_the_ratio) {
+    const conversion_side from = { 10000000000, 8, 300000, false, {} };
+    const conversion_side to = { 5000000000, 4, 200000, false, {} };
+    const conversion_return computed = calculate_conversion_return(from, to, 12345678, 1000.0, 2500);
+    const conversion_return precomputed = calculate_conversion_return(
+        { from.balance, from.precision, from.ratio, false, make_curve_coefficients(from.ratio) },
+        { to.balance, to.precision, to.ratio, false, make_curve_coefficients(to.ratio) },
+        12345678, 1000.0, 2500);
+
+    EXPECT_GT(computed.amount, 0);
+    EXPECT_EQ(computed.amount, precomputed.amount);
+    EXPECT_EQ(computed.fee, precomputed.fee);
+    EXPECT_EQ(computed.smart_supply, precomputed.smart_supply);
+}
+
+namespace {
+
+// the previous reserve to reserve path, a purchase of smart tokens followed by their sale
+double two_step_return(double from_balance, double amount, double to_balance, double supply, uint64_t from_ratio, uint64_t to_ratio) {
+    const double smart_tokens = calculate_purchase_return(from_balance, amount, supply, make_curve_coefficients(from_ratio));
+    return calculate_sale_return(to_balance, smart_tokens, supply + smart_tokens, make_curve_coefficients(to_ratio));
+}
+
+} // namespace
+
+TEST(BancorFormula, cross_reserve_return_matches_the_two_step_path) {
+    std::mt19937_64 random(20201019);
+    std::uniform_real_distribution<double> unit(0, 1);
+    const uint64_t ratios[] = { 1, 100000, 250000, 333333, 500000, 700000, 999999, 1000000 };
+    for (uint64_t from_ratio : ratios) {
+        for (uint64_t to_ratio : ratios) {
+            const curve_coefficients from_curve = make_curve_coefficients(from_ratio);
+            const curve_coefficients to_curve = make_curve_coefficients(to_ratio);
+            for (int i = 0; i < 2000; i++) {
+                const double from_balance = 1 + unit(random) * 1e9;
+                const double to_balance = 1 + unit(random) * 1e9;
+                const double supply = 1 + unit(random) * 1e9;
+                const double amount = from_balance * unit(random) * unit(random);
+
+                const double direct = calculate_cross_reserve_return(from_balance, amount, to_balance, from_curve, to_curve);
+                const double two_step = two_step_return(from_balance, amount, to_balance, supply, from_ratio, to_ratio);
+                EXPECT_GE(direct, 0);
+                EXPECT_LE(direct, to_balance);
+                // the two step path loses precision on large exponents and on 1 - (R / (R + E))^(1 / F2), the direct one does not
+                EXPECT_NEAR(direct, two_step, 1e-9 * to_balance) << from_ratio << " " << to_ratio << " " << amount;
+            }
+        }
+    }
+}
+
+TEST(BancorFormula, cross_reserve_return_does_not_depend_on_the_supply) {
+    const conversion_side from = { 10000000000, 8, 300000, false, make_curve_coefficients(300000) };
+    const conversion_side to = { 5000000000, 4, 200000, false, make_curve_coefficients(200000) };
+    const conversion_return small = calculate_conversion_return(from, to, 12345678, 1.0, 2500);
+    const conversion_return large = calculate_conversion_return(from, to, 12345678, 1e12, 2500);
+    EXPECT_EQ(small.amount, large.amount);
+    EXPECT_EQ(small.fee, large.fee);
+    EXPECT_EQ(small.smart_supply, 1.0);
+    EXPECT_EQ(large.smart_supply, 1e12);
+
+    const double direct = calculate_cross_reserve_return(100, 10, 5000, from.curve, to.curve);
+    EXPECT_NEAR(direct, 5000 * (1 - pow(100.0 / 110.0, 1.5)), 1e-9);
+    EXPECT_NEAR(amount_to_tokens(small.amount + small.fee, to.precision), two_step_return(100, 0.12345678, 500000, 1.0, 300000, 200000), 1e-4);
+}
+
+TEST(BancorFormula, cross_reserve_return_generalizes_quick_convert) {
+    const curve_coefficients curve = make_curve_coefficients(400000);
+    for (int64_t in : { 1, 10, 999, 123456789 }) {
+        const double direct = calculate_cross_reserve_return(1000000000, in, 2000000000, curve, curve);
+        EXPECT_NEAR(direct, double(quick_convert(1000000000, in, 2000000000)), 1.0) << in;
+    }
+}
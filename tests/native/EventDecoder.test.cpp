@@ -0,0 +1,117 @@
+#include "event_decoder.hpp"
+#include "fixture.hpp"
+
+using namespace events;
+
+namespace {
+
+const name CONVERTER = "bnt2dddcnvrt"_n;
+
+class converter_chain : public bancor_chain {
+    public:
+        converter_chain() {
+            add_legacy_converter({ CONVERTER, "bnt2dddrelay"_n, symbol("BNTDDD", 8), 1000,
+                { { BNT_TOKEN, to_asset("600.00000300 BNT"), 500000 }, { "ddd"_n, to_asset("1201.20000000 DDD"), 500000 } },
+                { { TEST_ACCOUNT_1, to_asset("12000.02009001 BNTDDD") } } });
+        }
+};
+
+// collects copies of the decoded events
+struct collector {
+    vector<conversion_event> conversions;
+    vector<price_data_event> prices;
+    vector<vector<reserve_state>> pool_states;
+    vector<conversion_fee_update_event> fee_updates;
+
+    void operator()(const conversion_event& e) { conversions.push_back(e); }
+    void operator()(const price_data_event& e) { prices.push_back(e); }
+    void operator()(const pool_state_event& e) { pool_states.emplace_back(e.reserves, e.reserves + e.reserves_count); }
+    void operator()(const conversion_fee_update_event& e) { fee_updates.push_back(e); }
+};
+
+} // namespace
+
+TEST(EventDecoder, decodes_the_events_of_a_conversion) {
+    converter_chain chain;
+    const int64_t ddd_balance = chain.balance("ddd"_n, TEST_ACCOUNT_1, symbol_code("DDD"));
+    chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("1.00000000 BNT"), "bnt2dddcnvrt DDD");
+    const string console = chain.console();
+
+    event_decoder decoder;
+    collector events;
+    const decode_stats stats = decoder.decode(console, events);
+    EXPECT_EQ(stats.events, 3);
+    EXPECT_EQ(stats.malformed, 0);
+
+    ASSERT_EQ(events.conversions.size(), 1);
+    const conversion_event& conversion = events.conversions[0];
+    EXPECT_EQ(conversion.version, "1.3");
+    EXPECT_EQ(conversion.memo, "1,bnt2dddcnvrt DDD,0.00000001,bnttestuser1");
+    EXPECT_EQ(conversion.from_contract, "bntbntbntbnt");
+    EXPECT_EQ(conversion.from_symbol, "BNT");
+    EXPECT_EQ(conversion.to_contract, "ddd");
+    EXPECT_EQ(conversion.to_symbol, "DDD");
+    EXPECT_EQ(conversion.amount, 1.0);
+    EXPECT_EQ(tokens_to_amount(conversion.return_amount, 8, rounding_mode::nearest), chain.balance("ddd"_n, TEST_ACCOUNT_1, symbol_code("DDD")) - ddd_balance);
+    EXPECT_GT(conversion.conversion_fee, 0);
+
+    ASSERT_EQ(events.prices.size(), 2);
+    EXPECT_EQ(events.prices[0].reserve_symbol, "BNT");
+    EXPECT_EQ(events.prices[1].reserve_symbol, "DDD");
+    EXPECT_EQ(events.prices[1].reserve_ratio, 0.5);
+    EXPECT_EQ(tokens_to_amount(events.prices[0].reserve_balance, 8, rounding_mode::nearest), chain.balance(BNT_TOKEN, CONVERTER, symbol_code("BNT")));
+}
+
+TEST(EventDecoder, decodes_pool_states_and_fee_updates) {
+    converter_chain chain;
+    chain.push_action(CONVERTER, "update"_n, CONVERTER, true, true, true, uint64_t(2500));
+    event_decoder decoder;
+    collector events;
+    decoder.decode(chain.console(), events);
+    ASSERT_EQ(events.fee_updates.size(), 1);
+    EXPECT_EQ(events.fee_updates[0].prev_fee, 1000);
+    EXPECT_EQ(events.fee_updates[0].new_fee, 2500);
+
+    chain.push_action(CONVERTER, "setpoolevent"_n, CONVERTER, true);
+    chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("1.00000000 BNT"), "bnt2dddcnvrt DDD");
+    decoder.decode(chain.console(), events);
+    ASSERT_EQ(events.pool_states.size(), 1);
+    const vector<reserve_state>& reserves = events.pool_states[0];
+    ASSERT_EQ(reserves.size(), 2);
+    // in the order of the reserves table
+    EXPECT_EQ(reserves[0].contract, "ddd");
+    EXPECT_EQ(reserves[0].symbol, "DDD");
+    EXPECT_EQ(tokens_to_amount(reserves[0].balance, 8, rounding_mode::nearest), chain.balance("ddd"_n, CONVERTER, symbol_code("DDD")));
+    EXPECT_EQ(reserves[1].contract, "bntbntbntbnt");
+    EXPECT_EQ(reserves[1].symbol, "BNT");
+    EXPECT_EQ(tokens_to_amount(reserves[1].balance, 8, rounding_mode::nearest), chain.balance(BNT_TOKEN, CONVERTER, symbol_code("BNT")));
+    EXPECT_EQ(reserves[1].ratio, 0.5);
+}
+
+TEST(EventDecoder, keeps_memos_verbatim) {
+    const string console = "{\"version\":\"1.3\",\"etype\":\"conversion\",\"memo\":\"1,a b,1,c;say \"hi\", \"from\":\",\"from_contract\":\"bntbntbntbnt\","
+        "\"from_symbol\":\"BNT\",\"to_contract\":\"ddd\",\"to_symbol\":\"DDD\",\"amount\":\"1.00000000000000000e+00\","
+        "\"return\":\"2.5e-01\",\"conversion_fee\":\"0\"}\n";
+    event_decoder decoder;
+    collector events;
+    EXPECT_EQ(decoder.decode(console, events).events, 1);
+    ASSERT_EQ(events.conversions.size(), 1);
+    EXPECT_EQ(events.conversions[0].memo, "1,a b,1,c;say \"hi\", \"from\":");
+    EXPECT_EQ(events.conversions[0].return_amount, 0.25);
+}
+
+TEST(EventDecoder, skips_other_output_and_malformed_events) {
+    const string fee_update = "{\"version\":\"1.1\",\"etype\":\"conversion_fee_update\",\"prev_fee\":\"1\",\"new_fee\":\"2\"}\n";
+    const string console = "debug output" + fee_update +
+        "{\"version\":\"1.1\",\"etype\":\"conversion_fee_update\",\"prev_fee\":\"x\",\"new_fee\":\"2\"}\n" +
+        "{\"version\":\"1.0\",\"etype\":\"unknown\",\"a\":\"b\"}\n" +
+        fee_update.substr(0, fee_update.size() - 10) + fee_update;
+
+    event_decoder decoder;
+    collector events;
+    const decode_stats stats = decoder.decode(console, events);
+    EXPECT_EQ(stats.events, 2);
+    EXPECT_EQ(stats.malformed, 2);
+    ASSERT_EQ(events.fee_updates.size(), 2);
+    EXPECT_EQ(events.fee_updates[1].new_fee, 2);
+}
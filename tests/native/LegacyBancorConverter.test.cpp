@@ -0,0 +1,727 @@
+#include <random>
+
+#include "fixture.hpp"
+
+namespace {
+
+const name CONVERTER = "bnt2dddcnvrt"_n;
+const name RELAY = "bnt2dddrelay"_n;
+const name RESERVE = "ddd"_n;
+const symbol_code BNT = symbol_code("BNT");
+const symbol_code DDD = symbol_code("DDD");
+const symbol_code BNTDDD = symbol_code("BNTDDD");
+
+class converter_chain : public bancor_chain {
+    public:
+        converter_chain(uint64_t fee = 1000) {
+            add_legacy_converter({ CONVERTER, RELAY, symbol("BNTDDD", 8), fee,
+                { { BNT_TOKEN, to_asset("600.00000300 BNT"), 500000 }, { RESERVE, to_asset("1201.20000000 DDD"), 500000 } },
+                { { TEST_ACCOUNT_1, to_asset("12000.02009001 BNTDDD") } } });
+        }
+};
+
+// fee taken from a return, once per hop, rounded up
+int64_t expected_fee(int64_t amount, uint64_t fee, int hops) {
+    long double remaining = 1;
+    for (int i = 0; i < hops; i++)
+        remaining *= (1000000 - fee) / 1000000.0L;
+    return int64_t(ceill(amount * (1 - remaining) - 1e-9L));
+}
+
+} // namespace
+
+TEST(LegacyBancorConverter, converts_between_reserves) {
+    converter_chain chain;
+    const int64_t bnt_balance = chain.balance(BNT_TOKEN, CONVERTER, BNT);
+    const int64_t ddd_balance = chain.balance(RESERVE, CONVERTER, DDD);
+
+    chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("1.00000000 BNT"), "bnt2dddcnvrt DDD");
+
+    const int64_t to_amount = mul_div(100000000, ddd_balance, bnt_balance + 100000000);
+    const int64_t expected = to_amount - expected_fee(to_amount, 1000, 2);
+    EXPECT_EQ(chain.balance(RESERVE, TEST_ACCOUNT_1, DDD), expected);
+    EXPECT_EQ(chain.balance(RESERVE, CONVERTER, DDD), ddd_balance - expected);
+    EXPECT_EQ(chain.balance(BNT_TOKEN, CONVERTER, BNT), bnt_balance + 100000000);
+    EXPECT_EQ(chain.balance(BNT_TOKEN, NETWORK, BNT), 0);
+    EXPECT_NE(chain.console().find("\"etype\":\"conversion\""), string::npos);
+    EXPECT_NE(chain.console().find("\"etype\":\"price_data\""), string::npos);
+}
+
+TEST(LegacyBancorConverter, rejects_returns_below_min_return) {
+    converter_chain chain;
+    const int64_t user_balance = chain.balance(BNT_TOKEN, TEST_ACCOUNT_1, BNT);
+
+    expect_assert([&] {
+        chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("1.00000000 BNT"), "bnt2dddcnvrt DDD", "3.00000000");
+    }, "below min return");
+    EXPECT_EQ(chain.balance(BNT_TOKEN, TEST_ACCOUNT_1, BNT), user_balance);
+    EXPECT_EQ(chain.balance(RESERVE, TEST_ACCOUNT_1, DDD), 0);
+}
+
+TEST(LegacyBancorConverter, only_converts_from_the_network) {
+    converter_chain chain;
+    expect_assert([&] {
+        chain.push_action(BNT_TOKEN, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, CONVERTER, to_asset("1.00000000 BNT"),
+            "1,bnt2dddcnvrt DDD,0.00000001,bnttestuser1");
+    }, "converter can only receive from network contract");
+}
+
+TEST(LegacyBancorConverter, buys_and_sells_pool_tokens) {
+    converter_chain chain;
+    const int64_t supply = chain.supply(RELAY, BNTDDD);
+    const int64_t pool_tokens = chain.balance(RELAY, TEST_ACCOUNT_1, BNTDDD);
+
+    chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("10.00000000 BNT"), "bnt2dddcnvrt BNTDDD");
+    const int64_t bought = chain.balance(RELAY, TEST_ACCOUNT_1, BNTDDD) - pool_tokens;
+    EXPECT_GT(bought, 0);
+    EXPECT_EQ(chain.supply(RELAY, BNTDDD), supply + bought);
+
+    const int64_t ddd_balance = chain.balance(RESERVE, TEST_ACCOUNT_1, DDD);
+    chain.convert(TEST_ACCOUNT_1, RELAY, asset(bought, symbol("BNTDDD", 8)), "bnt2dddcnvrt DDD");
+    EXPECT_EQ(chain.supply(RELAY, BNTDDD), supply);
+    EXPECT_EQ(chain.balance(RELAY, CONVERTER, BNTDDD), 0);
+    EXPECT_GT(chain.balance(RESERVE, TEST_ACCOUNT_1, DDD), ddd_balance);
+}
+
+TEST(LegacyBancorConverter, emits_pool_state_when_enabled) {
+    converter_chain chain;
+    chain.push_action(CONVERTER, "setpoolevent"_n, CONVERTER, true);
+
+    chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("1.00000000 BNT"), "bnt2dddcnvrt DDD");
+    EXPECT_NE(chain.console().find("\"etype\":\"pool_state\""), string::npos);
+    EXPECT_EQ(chain.console().find("\"etype\":\"price_data\""), string::npos);
+}
+
+TEST(LegacyBancorConverter, randomized_conversions_conserve_balances) {
+    converter_chain chain;
+    std::mt19937_64 random(20201019);
+    const vector<std::pair<name, symbol>> tokens = {
+        { BNT_TOKEN, symbol("BNT", 8) }, { RESERVE, symbol("DDD", 8) }, { RELAY, symbol("BNTDDD", 8) }
+    };
+
+    const int64_t total_bnt = chain.balance(BNT_TOKEN, TEST_ACCOUNT_1, BNT) + chain.balance(BNT_TOKEN, CONVERTER, BNT);
+    const int64_t total_ddd = chain.balance(RESERVE, CONVERTER, DDD);
+
+    for (int i = 0; i < 2000; i++) {
+        const auto& [from_token, from_symbol] = tokens[random() % tokens.size()];
+        const auto& [to_token, to_symbol] = tokens[random() % tokens.size()];
+        const int64_t balance = chain.balance(from_token, TEST_ACCOUNT_1, from_symbol.code());
+        if (from_token == to_token || balance < 2)
+            continue;
+
+        const int64_t quantity = 1 + random() % std::min<int64_t>(balance / 2, 1000000000);
+        try {
+            chain.convert(TEST_ACCOUNT_1, from_token, asset(quantity, from_symbol), "bnt2dddcnvrt " + to_symbol.code().to_string());
+        }
+        catch (const eosio::eosio_assert_exception& e) {
+            EXPECT_NE(string(e.what()).find("below min return"), string::npos) << e.what();
+            continue;
+        }
+
+        ASSERT_EQ(chain.balance(BNT_TOKEN, TEST_ACCOUNT_1, BNT) + chain.balance(BNT_TOKEN, CONVERTER, BNT), total_bnt);
+        ASSERT_EQ(chain.balance(RESERVE, TEST_ACCOUNT_1, DDD) + chain.balance(RESERVE, CONVERTER, DDD), total_ddd);
+        ASSERT_EQ(chain.balance(RELAY, TEST_ACCOUNT_1, BNTDDD), chain.supply(RELAY, BNTDDD));
+    }
+}
+
+namespace {
+
+struct batch_trade {
+    name recipient;
+    asset quantity;
+    symbol to;
+};
+
+const vector<std::pair<name, symbol>> DDD_TOKENS = {
+    { BNT_TOKEN, symbol("BNT", 8) }, { RESERVE, symbol("DDD", 8) }, { RELAY, symbol("BNTDDD", 8) }
+};
+
+name token_contract(symbol_code sym) {
+    for (const auto& [token, token_symbol] : DDD_TOKENS)
+        if (token_symbol.code() == sym)
+            return token;
+    return name();
+}
+
+vector<batch_trade> random_batch(size_t count, uint64_t seed) {
+    std::mt19937_64 random(seed);
+    vector<batch_trade> trades;
+    while (trades.size() < count) {
+        const symbol from = DDD_TOKENS[random() % DDD_TOKENS.size()].second;
+        const symbol to = DDD_TOKENS[random() % DDD_TOKENS.size()].second;
+        if (from == to)
+            continue;
+        trades.push_back({ random() % 2 ? TEST_ACCOUNT_1 : TEST_ACCOUNT_2, asset(1 + random() % 500000000, from), to });
+    }
+    return trades;
+}
+
+// balances of the test accounts and of the converter, and the pool token supply
+vector<int64_t> ddd_state(const converter_chain& chain) {
+    vector<int64_t> state = { chain.supply(RELAY, BNTDDD) };
+    for (name owner : { TEST_ACCOUNT_1, TEST_ACCOUNT_2, CONVERTER })
+        for (const auto& [token, token_symbol] : DDD_TOKENS)
+            state.push_back(chain.balance(token, owner, token_symbol.code()));
+    return state;
+}
+
+// gives TEST_ACCOUNT_1 some DDD to convert from
+void fund_test_account(converter_chain& chain) {
+    chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("100.00000000 BNT"), "bnt2dddcnvrt DDD");
+}
+
+void deposit_batch(converter_chain& chain, const vector<batch_trade>& trades) {
+    for (const auto& [token, token_symbol] : DDD_TOKENS) {
+        asset total(0, token_symbol);
+        for (const batch_trade& trade : trades)
+            if (trade.quantity.symbol == token_symbol)
+                total += trade.quantity;
+        if (total.amount == 0)
+            continue;
+        chain.push_action(token, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, NETWORK, total, "batch");
+        chain.push_action(token, "transfer"_n, NETWORK, NETWORK, CONVERTER, total, "batch");
+    }
+}
+
+vector<LegacyBancorConverter::batch_conversion> batch_conversions(const vector<batch_trade>& trades) {
+    vector<LegacyBancorConverter::batch_conversion> conversions;
+    for (const batch_trade& trade : trades)
+        conversions.push_back({ trade.recipient, trade.quantity, asset(1, trade.to), "1,bnt2dddcnvrt " + trade.to.code().to_string() + ",0.00000001," + trade.recipient.to_string() });
+    return conversions;
+}
+
+} // namespace
+
+TEST(LegacyBancorConverter, batch_matches_sequential_conversions) {
+    const vector<batch_trade> trades = random_batch(60, 20201019);
+
+    vector<int64_t> sequential_state;
+    {
+        converter_chain chain;
+        fund_test_account(chain);
+        for (const batch_trade& trade : trades)
+            chain.push_action(token_contract(trade.quantity.symbol.code()), "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, NETWORK, trade.quantity,
+                "1,bnt2dddcnvrt " + trade.to.code().to_string() + ",0.00000001," + trade.recipient.to_string());
+        sequential_state = ddd_state(chain);
+    }
+
+    converter_chain chain;
+    fund_test_account(chain);
+    deposit_batch(chain, trades);
+    chain.push_action(CONVERTER, "convertbatch"_n, NETWORK, batch_conversions(trades));
+    EXPECT_EQ(ddd_state(chain), sequential_state);
+
+    LegacyBancorConverter::deposits deposits_table(CONVERTER, CONVERTER.value);
+    EXPECT_EQ(deposits_table.begin(), deposits_table.end());
+
+    // a single transfer per recipient and token, and the pool tokens netted into a single retire or issue
+    size_t transfers = 0, supply_changes = 0;
+    for (const eosio_mock::pending_action& act : chain.executed_actions()) {
+        transfers += act.name == "transfer"_n;
+        supply_changes += act.name == "retire"_n || act.name == "issue"_n;
+    }
+    EXPECT_LE(transfers, 6);
+    EXPECT_LE(supply_changes, 1);
+    EXPECT_EQ(std::count(chain.console().begin(), chain.console().end(), '\n'), trades.size() + 2);
+}
+
+TEST(LegacyBancorConverter, batch_keeps_unconverted_deposits) {
+    converter_chain chain;
+    const vector<batch_trade> trades = { { TEST_ACCOUNT_2, to_asset("2.00000000 BNT"), symbol("DDD", 8) } };
+    deposit_batch(chain, trades);
+    chain.push_action(CONVERTER, "convertbatch"_n, NETWORK, batch_conversions({ { TEST_ACCOUNT_2, to_asset("0.50000000 BNT"), symbol("DDD", 8) } }));
+
+    LegacyBancorConverter::deposits deposits_table(CONVERTER, CONVERTER.value);
+    EXPECT_EQ(deposits_table.get(BNT.raw()).quantity, to_asset("1.50000000 BNT"));
+    EXPECT_GT(chain.balance(RESERVE, TEST_ACCOUNT_2, DDD), 0);
+
+    expect_assert([&] {
+        chain.push_action(CONVERTER, "convertbatch"_n, NETWORK, batch_conversions({ { TEST_ACCOUNT_2, to_asset("1.50000001 BNT"), symbol("DDD", 8) } }));
+    }, "1.50000001 BNT was not deposited");
+}
+
+TEST(LegacyBancorConverter, batch_requires_the_network) {
+    converter_chain chain;
+    const vector<batch_trade> trades = { { TEST_ACCOUNT_1, to_asset("1.00000000 BNT"), symbol("DDD", 8) } };
+    expect_assert([&] {
+        chain.push_action(CONVERTER, "convertbatch"_n, TEST_ACCOUNT_1, batch_conversions(trades));
+    }, "missing authority");
+    expect_assert([&] {
+        chain.push_action(BNT_TOKEN, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, CONVERTER, to_asset("1.00000000 BNT"), "batch");
+    }, "converter can only receive from network contract");
+}
+
+TEST(LegacyBancorConverter, conversions_exclude_pending_deposits) {
+    int64_t without_deposits;
+    {
+        converter_chain chain;
+        chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("1.00000000 BNT"), "bnt2dddcnvrt DDD");
+        without_deposits = chain.balance(RESERVE, TEST_ACCOUNT_1, DDD);
+    }
+    converter_chain chain;
+    deposit_batch(chain, { { TEST_ACCOUNT_2, to_asset("200.00000000 BNT"), symbol("DDD", 8) } });
+    chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("1.00000000 BNT"), "bnt2dddcnvrt DDD");
+    EXPECT_EQ(chain.balance(RESERVE, TEST_ACCOUNT_1, DDD), without_deposits);
+}
+
+TEST(LegacyBancorConverter, refunds_deposits_to_the_network_only) {
+    converter_chain chain;
+    deposit_batch(chain, { { TEST_ACCOUNT_2, to_asset("2.00000000 BNT"), symbol("DDD", 8) } });
+    const int64_t bnt_balance = chain.balance(BNT_TOKEN, TEST_ACCOUNT_2, BNT);
+
+    expect_assert([&] {
+        chain.push_action(CONVERTER, "refund"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_2, to_asset("1.00000000 BNT"));
+    }, "missing authority");
+    expect_assert([&] {
+        chain.push_action(CONVERTER, "refund"_n, NETWORK, TEST_ACCOUNT_2, to_asset("2.00000001 BNT"));
+    }, "quantity exceeds the deposit");
+
+    chain.push_action(CONVERTER, "refund"_n, NETWORK, TEST_ACCOUNT_2, to_asset("0.50000000 BNT"));
+    LegacyBancorConverter::deposits deposits_table(CONVERTER, CONVERTER.value);
+    EXPECT_EQ(deposits_table.get(BNT.raw()).quantity, to_asset("1.50000000 BNT"));
+    EXPECT_EQ(chain.balance(BNT_TOKEN, TEST_ACCOUNT_2, BNT), bnt_balance + 50000000);
+
+    chain.push_action(CONVERTER, "refund"_n, NETWORK, TEST_ACCOUNT_2, to_asset("1.50000000 BNT"));
+    EXPECT_EQ(deposits_table.find(BNT.raw()), deposits_table.end());
+    EXPECT_EQ(chain.balance(BNT_TOKEN, TEST_ACCOUNT_2, BNT), bnt_balance + 200000000);
+}
+
+TEST(LegacyBancorConverter, setreserve_precomputes_curves) {
+    converter_chain chain;
+    chain.push_action(CONVERTER, "setreserve"_n, CONVERTER, RESERVE, symbol("DDD", 8), uint64_t(250000), true);
+
+    LegacyBancorConverter::reserves reserves_table(CONVERTER, CONVERTER.value);
+    const curve_coefficients bnt_curve = reserves_table.get(BNT.raw()).curve.value();
+    const curve_coefficients ddd_curve = reserves_table.get(DDD.raw()).curve.value();
+    EXPECT_EQ(bnt_curve.kernel, uint8_t(curve_kernel::square_root));
+    EXPECT_EQ(ddd_curve.kernel, uint8_t(curve_kernel::generic));
+    EXPECT_EQ(ddd_curve.purchase_exponent, 0.25);
+    EXPECT_EQ(ddd_curve.sale_exponent, 4.0);
+}
+
+TEST(LegacyBancorConverter, converts_with_reserves_set_before_curves) {
+    int64_t with_curves;
+    {
+        converter_chain chain;
+        chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("10.00000000 BNT"), "bnt2dddcnvrt BNTDDD");
+        with_curves = chain.balance(RELAY, TEST_ACCOUNT_1, BNTDDD);
+    }
+
+    converter_chain chain;
+    LegacyBancorConverter::reserves reserves_table(CONVERTER, CONVERTER.value);
+    for (auto reserve = reserves_table.begin(); reserve != reserves_table.end(); reserve++)
+        reserves_table.modify(reserve, same_payer, [](auto& r) { r.curve.reset(); });
+
+    chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("10.00000000 BNT"), "bnt2dddcnvrt BNTDDD");
+    EXPECT_EQ(chain.balance(RELAY, TEST_ACCOUNT_1, BNTDDD), with_curves);
+}
+
+TEST(LegacyBancorConverter, reads_only_the_state_each_branch_needs) {
+    converter_chain chain;
+    const name ACCOUNTS = "accounts"_n;
+    const name STAT = "stat"_n;
+
+    // both balances, and the supply for the price events
+    chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("1.00000000 BNT"), "bnt2dddcnvrt DDD");
+    EXPECT_EQ(chain.db_reads(CONVERTER, ACCOUNTS), 2);
+    EXPECT_EQ(chain.db_reads(CONVERTER, STAT), 1);
+
+    // the pool token has no balance
+    chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("1.00000000 BNT"), "bnt2dddcnvrt BNTDDD");
+    EXPECT_EQ(chain.db_reads(CONVERTER, ACCOUNTS), 1);
+    EXPECT_EQ(chain.db_reads(CONVERTER, STAT), 1);
+
+    chain.convert(TEST_ACCOUNT_1, RELAY, to_asset("1.00000000 BNTDDD"), "bnt2dddcnvrt DDD");
+    EXPECT_EQ(chain.db_reads(CONVERTER, ACCOUNTS), 1);
+    EXPECT_EQ(chain.db_reads(CONVERTER, STAT), 1);
+}
+
+namespace {
+
+const name POOLS = "legacypools"_n;
+const name DDD_POOL_TOKEN = "dddpooltoken"_n;
+const name EEE_POOL_TOKEN = "eeepooltoken"_n;
+const name EEE_RESERVE = "eee"_n;
+const symbol_code EEE = symbol_code("EEE");
+const symbol_code BNTEEE = symbol_code("BNTEEE");
+
+// the pool of converter_chain, and a second pool sharing its BNT reserve, hosted by a single account
+class pools_chain : public bancor_chain {
+    public:
+        pools_chain() {
+            add_hosted_pool({ POOLS, DDD_POOL_TOKEN, symbol("BNTDDD", 8), 1000,
+                { { BNT_TOKEN, to_asset("600.00000300 BNT"), 500000 }, { RESERVE, to_asset("1201.20000000 DDD"), 500000 } },
+                { { TEST_ACCOUNT_1, to_asset("12000.02009001 BNTDDD") } } });
+            add_hosted_pool({ POOLS, EEE_POOL_TOKEN, symbol("BNTEEE", 4), 2500,
+                { { BNT_TOKEN, to_asset("300.00000000 BNT"), 600000 }, { EEE_RESERVE, to_asset("900.0000 EEE"), 200000 } },
+                { { TEST_ACCOUNT_1, to_asset("5000.0000 BNTEEE") } } });
+        }
+
+        int64_t reserve_balance(symbol_code pool, symbol_code reserve) const {
+            LegacyBancorConverter::reserves reserves_table(POOLS, pool.raw());
+            return reserves_table.get(reserve.raw()).balance.value();
+        }
+};
+
+// balance changes of TEST_ACCOUNT_1 over the conversions of the BNTDDD pool, converted through `converter`
+vector<int64_t> ddd_pool_trades(bancor_chain& chain, const string& converter, name pool_token) {
+    const vector<std::tuple<name, string, string>> trades = {
+        { BNT_TOKEN, "10.00000000 BNT", "DDD" }, { RESERVE, "3.50000000 DDD", "BNT" },
+        { BNT_TOKEN, "25.00000000 BNT", "BNTDDD" }, { pool_token, "100.00000000 BNTDDD", "DDD" }
+    };
+    vector<int64_t> changes;
+    for (const auto& [token, quantity, to] : trades) {
+        const int64_t bnt = chain.balance(BNT_TOKEN, TEST_ACCOUNT_1, BNT);
+        const int64_t ddd = chain.balance(RESERVE, TEST_ACCOUNT_1, DDD);
+        const int64_t pool_tokens = chain.balance(pool_token, TEST_ACCOUNT_1, BNTDDD);
+        chain.convert(TEST_ACCOUNT_1, token, to_asset(quantity), converter + " " + to);
+        changes.push_back(chain.balance(BNT_TOKEN, TEST_ACCOUNT_1, BNT) - bnt);
+        changes.push_back(chain.balance(RESERVE, TEST_ACCOUNT_1, DDD) - ddd);
+        changes.push_back(chain.balance(pool_token, TEST_ACCOUNT_1, BNTDDD) - pool_tokens);
+    }
+    return changes;
+}
+
+} // namespace
+
+TEST(LegacyBancorConverter, hosted_pools_convert_like_single_pool_converters) {
+    vector<int64_t> single_pool;
+    {
+        converter_chain chain;
+        single_pool = ddd_pool_trades(chain, "bnt2dddcnvrt", RELAY);
+    }
+
+    pools_chain chain;
+    EXPECT_EQ(ddd_pool_trades(chain, "legacypools:BNTDDD", DDD_POOL_TOKEN), single_pool);
+
+    // the pools share the account's BNT balance, each tracks its own share
+    EXPECT_EQ(chain.reserve_balance(BNTDDD, BNT) + chain.reserve_balance(BNTEEE, BNT), chain.balance(BNT_TOKEN, POOLS, BNT));
+    EXPECT_EQ(chain.reserve_balance(BNTDDD, DDD), chain.balance(RESERVE, POOLS, DDD));
+    EXPECT_EQ(chain.reserve_balance(BNTEEE, BNT), to_asset("300.00000000 BNT").amount);
+}
+
+TEST(LegacyBancorConverter, hosted_pools_track_their_reserves) {
+    pools_chain chain;
+    const int64_t bnt_balance = chain.reserve_balance(BNTEEE, BNT);
+    const int64_t eee_balance = chain.reserve_balance(BNTEEE, EEE);
+
+    chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("1.00000000 BNT"), "legacypools:BNTEEE EEE");
+    const int64_t eee_return = chain.balance(EEE_RESERVE, TEST_ACCOUNT_1, EEE);
+    EXPECT_GT(eee_return, 0);
+    EXPECT_EQ(chain.reserve_balance(BNTEEE, BNT), bnt_balance + 100000000);
+    EXPECT_EQ(chain.reserve_balance(BNTEEE, EEE), eee_balance - eee_return);
+    EXPECT_EQ(chain.reserve_balance(BNTDDD, BNT), to_asset("600.00000300 BNT").amount);
+
+    const int64_t supply = chain.supply(EEE_POOL_TOKEN, BNTEEE);
+    chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("1.00000000 BNT"), "legacypools:BNTEEE BNTEEE", "0.0001");
+    EXPECT_GT(chain.supply(EEE_POOL_TOKEN, BNTEEE), supply);
+    EXPECT_EQ(chain.reserve_balance(BNTEEE, BNT), bnt_balance + 200000000);
+
+    chain.push_action(BNT_TOKEN, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, POOLS, to_asset("5.00000000 BNT"), "setup:BNTEEE");
+    EXPECT_EQ(chain.reserve_balance(BNTEEE, BNT), bnt_balance + 700000000);
+    EXPECT_EQ(chain.reserve_balance(BNTDDD, BNT) + chain.reserve_balance(BNTEEE, BNT), chain.balance(BNT_TOKEN, POOLS, BNT));
+
+    expect_assert([&] {
+        chain.push_action(POOLS, "delreserve"_n, POOLS, BNT, binary_extension<symbol_code>(BNTEEE));
+    }, "may delete only empty reserves");
+}
+
+TEST(LegacyBancorConverter, hosted_pools_are_selected_by_the_memo) {
+    pools_chain chain;
+    expect_assert([&] {
+        chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("1.00000000 BNT"), "legacypools DDD");
+    }, "settings do not exist");
+    expect_assert([&] {
+        chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("1.00000000 BNT"), "legacypools:BNTEEE DDD");
+    }, "reserve DDD not found");
+    chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("1.00000000 BNT"), "legacypools:BNTDDD DDD");
+    expect_assert([&] {
+        chain.push_action(RESERVE, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, POOLS, to_asset("0.10000000 DDD"), "setup:BNTEEE");
+    }, "reserve DDD not found");
+
+    // another token contract cannot fund a reserve with a token of the same symbol
+    chain.set_contract("fakebnt"_n, eosio_mock::token_contract());
+    chain.push_action("fakebnt"_n, "create"_n, "fakebnt"_n, "fakebnt"_n, to_asset("1000.00000000 BNT"));
+    chain.push_action("fakebnt"_n, "issue"_n, "fakebnt"_n, "fakebnt"_n, to_asset("1000.00000000 BNT"), "");
+    expect_assert([&] {
+        chain.push_action("fakebnt"_n, "transfer"_n, "fakebnt"_n, "fakebnt"_n, POOLS, to_asset("1000.00000000 BNT"), "setup:BNTDDD");
+    }, "unknown 'from' contract fakebnt");
+}
+
+TEST(LegacyBancorConverter, accounts_hold_a_single_pool_or_hosted_pools) {
+    converter_chain chain;
+    expect_assert([&] {
+        chain.push_action(CONVERTER, "init"_n, CONVERTER, RELAY, asset(0, symbol("BNTDDD", 8)), true, true, NETWORK, false, uint64_t(30000), uint64_t(0),
+            binary_extension<symbol_code>(BNTDDD));
+    }, "account already holds a single pool");
+    expect_assert([&] {
+        chain.push_action(CONVERTER, "init"_n, CONVERTER, RELAY, asset(0, symbol("BNTDDD", 8)), true, true, NETWORK, false, uint64_t(30000), uint64_t(0),
+            binary_extension<symbol_code>(DDD));
+    }, "pool must be the smart currency symbol");
+
+    pools_chain pools;
+    expect_assert([&] {
+        pools.push_action(POOLS, "init"_n, POOLS, RELAY, asset(0, symbol("BNTDDD", 8)), true, true, NETWORK, false, uint64_t(30000), uint64_t(0),
+            binary_extension<symbol_code>());
+    }, "account already hosts pools");
+    const LegacyBancorConverter::pools pools_table(POOLS, POOLS.value);
+    EXPECT_EQ(std::distance(pools_table.begin(), pools_table.end()), 2);
+}
+
+TEST(LegacyBancorConverter, multi_hop_conversions_keep_the_memo_version) {
+    vector<int64_t> returns;
+    for (const string version : { "1", "01", "02", "2.0" }) {
+        pools_chain chain;
+        chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("10.00000000 BNT"), "legacypools:BNTDDD DDD");
+        chain.push_action(RESERVE, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, NETWORK, to_asset("1.00000000 DDD"), "batch"); // held by the network
+        const int64_t eee = chain.balance(EEE_RESERVE, TEST_ACCOUNT_1, EEE);
+
+        // sent by the network to the first converter, within the inline action depth of the harness
+        const string memo = version + ",legacypools:BNTDDD BNT legacypools:BNTEEE EEE,0.0001," + TEST_ACCOUNT_1.to_string();
+        chain.push_action(RESERVE, "transfer"_n, NETWORK, NETWORK, POOLS, to_asset("1.00000000 DDD"), memo);
+        returns.push_back(chain.balance(EEE_RESERVE, TEST_ACCOUNT_1, EEE) - eee);
+
+        // the memo of the second hop, sent back to the network by the first one
+        const auto hop = std::find_if(chain.executed_actions().begin(), chain.executed_actions().end(), [](const eosio_mock::pending_action& act) {
+            return act.account == BNT_TOKEN && act.name == "transfer"_n;
+        });
+        ASSERT_NE(hop, chain.executed_actions().end());
+        const string next = std::get<3>(std::any_cast<std::tuple<name, name, asset, string>>(hop->data));
+        EXPECT_EQ(next, version + ",legacypools:BNTEEE EEE,0.0001," + TEST_ACCOUNT_1.to_string() + ";convert");
+    }
+    EXPECT_GT(returns[0], 0);
+    for (int64_t eee : returns)
+        EXPECT_EQ(eee, returns[0]);
+}
+
+TEST(LegacyBancorConverter, hosted_pools_convert_batches) {
+    pools_chain chain;
+    chain.push_action(BNT_TOKEN, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, NETWORK, to_asset("4.00000000 BNT"), "batch");
+    chain.push_action(BNT_TOKEN, "transfer"_n, NETWORK, NETWORK, POOLS, to_asset("4.00000000 BNT"), "batch:BNTDDD");
+    const int64_t bnt_balance = chain.reserve_balance(BNTDDD, BNT);
+    const int64_t ddd_balance = chain.reserve_balance(BNTDDD, DDD);
+
+    chain.push_action(POOLS, "convertbatch"_n, NETWORK, vector<LegacyBancorConverter::batch_conversion>{
+        { TEST_ACCOUNT_2, to_asset("1.00000000 BNT"), to_asset("0.00000001 DDD"), "" },
+        { TEST_ACCOUNT_2, to_asset("3.00000000 BNT"), to_asset("0.00000001 DDD"), "" }
+    }, binary_extension<symbol_code>(BNTDDD));
+
+    const int64_t ddd_return = chain.balance(RESERVE, TEST_ACCOUNT_2, DDD);
+    EXPECT_GT(ddd_return, 0);
+    EXPECT_EQ(chain.reserve_balance(BNTDDD, BNT), bnt_balance + 400000000);
+    EXPECT_EQ(chain.reserve_balance(BNTDDD, DDD), ddd_balance - ddd_return);
+    LegacyBancorConverter::deposits deposits_table(POOLS, BNTDDD.raw());
+    EXPECT_EQ(deposits_table.begin(), deposits_table.end());
+}
+
+TEST(LegacyBancorConverter, converts_with_compact_and_route_memos) {
+    const string memo = "1,bnt2dddcnvrt DDD,0.00000001,bnttestuser2";
+    memo_structure compact = parse_memo(memo);
+    compact.version = "2";
+    memo_structure route = compact;
+    route.route_id = 1;
+    route.route_hops = 1;
+
+    vector<int64_t> returns;
+    for (const string& sent : { memo, build_memo(compact), build_memo(route) }) {
+        converter_chain chain;
+        chain.push_action(NETWORK, "addroute"_n, NETWORK, uint64_t(1), ::path{ "bnt2dddcnvrt", "DDD" });
+        chain.push_action(BNT_TOKEN, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, NETWORK, to_asset("10.00000000 BNT"), sent);
+        returns.push_back(chain.balance(RESERVE, TEST_ACCOUNT_2, DDD));
+
+        // the memo the converter sends back to the network, in the version it received
+        const auto hop = std::find_if(chain.executed_actions().begin(), chain.executed_actions().end(), [](const eosio_mock::pending_action& act) {
+            return act.account == RESERVE && act.name == "transfer"_n;
+        });
+        ASSERT_NE(hop, chain.executed_actions().end());
+        const memo_structure next = parse_memo(std::get<3>(std::any_cast<std::tuple<name, name, asset, string>>(hop->data)));
+        EXPECT_EQ(next.version, sent.substr(0, 1));
+        EXPECT_EQ(next.route_offset, sent == memo || sent == build_memo(compact) ? 0 : 1);
+        EXPECT_EQ(next.dest_account, "bnttestuser2");
+    }
+    EXPECT_GT(returns[0], 0);
+    EXPECT_EQ(returns[1], returns[0]);
+    EXPECT_EQ(returns[2], returns[0]);
+}
+
+TEST(LegacyBancorConverter, reads_routes_of_the_network_only) {
+    converter_chain chain;
+    chain.push_action(NETWORK, "addroute"_n, NETWORK, uint64_t(1), ::path{ "bnt2dddcnvrt", "DDD" });
+    memo_structure route = parse_memo("1,,0.00000001,bnttestuser2");
+    route.version = "2";
+    route.route_id = 1;
+    route.route_hops = 1;
+
+    expect_assert([&] {
+        chain.push_action(BNT_TOKEN, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, CONVERTER, to_asset("10.00000000 BNT"), build_memo(route));
+    }, "converter can only receive from network contract");
+    EXPECT_EQ(chain.db_reads(CONVERTER, "routes"_n), 0);
+
+    route.route_id = 2;
+    expect_assert([&] {
+        chain.push_action(BNT_TOKEN, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, NETWORK, to_asset("10.00000000 BNT"), build_memo(route));
+    }, "route not found");
+}
+
+TEST(LegacyBancorConverter, hosted_pools_look_up_their_network_by_key) {
+    const string memo = "1,legacypools:BNTEEE EEE,0.0001,bnttestuser2";
+    memo_structure route = parse_memo(memo);
+    route.version = "2";
+    route.route_id = 1;
+    route.route_hops = 1;
+
+    pools_chain chain;
+    chain.push_action(BNT_TOKEN, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, NETWORK, to_asset("1.00000000 BNT"), memo);
+    const uint64_t settings_reads = chain.db_reads(POOLS, "settings"_n);
+    const int64_t csv_return = chain.balance(EEE_RESERVE, TEST_ACCOUNT_2, EEE);
+
+    chain.push_action(NETWORK, "addroute"_n, NETWORK, uint64_t(1), ::path{ "legacypools:BNTEEE", "EEE" });
+    chain.push_action(BNT_TOKEN, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, NETWORK, to_asset("1.00000000 BNT"), build_memo(route));
+    EXPECT_GT(chain.balance(EEE_RESERVE, TEST_ACCOUNT_2, EEE), csv_return);
+    // the single pool settings are looked up, not the settings of every hosted pool
+    EXPECT_EQ(chain.db_reads(POOLS, "settings"_n), settings_reads + 1);
+    EXPECT_EQ(chain.db_reads(POOLS, "pools"_n), 1);
+}
+
+namespace {
+
+// balance changes of TEST_ACCOUNT_1 over conversions from and to the pool token
+vector<int64_t> pool_token_trades(converter_chain& chain) {
+    const vector<std::tuple<name, string, string>> trades = {
+        { RELAY, "100.00000000 BNTDDD", "DDD" }, { BNT_TOKEN, "25.00000000 BNT", "BNTDDD" }, { RELAY, "40.00000000 BNTDDD", "BNT" },
+        { BNT_TOKEN, "3.00000000 BNT", "DDD" }, { RELAY, "250.00000000 BNTDDD", "DDD" }, { RELAY, "7.00000000 BNTDDD", "BNT" }
+    };
+    vector<int64_t> changes;
+    for (const auto& [token, quantity, to] : trades) {
+        const int64_t bnt = chain.balance(BNT_TOKEN, TEST_ACCOUNT_1, BNT);
+        const int64_t ddd = chain.balance(RESERVE, TEST_ACCOUNT_1, DDD);
+        chain.convert(TEST_ACCOUNT_1, token, to_asset(quantity), "bnt2dddcnvrt " + to);
+        changes.push_back(chain.balance(BNT_TOKEN, TEST_ACCOUNT_1, BNT) - bnt);
+        changes.push_back(chain.balance(RESERVE, TEST_ACCOUNT_1, DDD) - ddd);
+    }
+    return changes;
+}
+
+size_t retire_actions(const bancor_chain& chain) {
+    return std::count_if(chain.executed_actions().begin(), chain.executed_actions().end(), [](const eosio_mock::pending_action& act) {
+        return act.name == "retire"_n;
+    });
+}
+
+} // namespace
+
+TEST(LegacyBancorConverter, pending_retirements_keep_returns_exact) {
+    vector<int64_t> retired_changes;
+    int64_t retired_supply;
+    {
+        converter_chain chain;
+        retired_changes = pool_token_trades(chain);
+        retired_supply = chain.supply(RELAY, BNTDDD);
+    }
+
+    converter_chain chain;
+    const int64_t offset = LegacyBancorConverter::settings(CONVERTER, CONVERTER.value).get("settings"_n.value).smart_currency.amount;
+    chain.push_action(CONVERTER, "setretire"_n, CONVERTER, int64_t(to_asset("1000.00000000 BNTDDD").amount));
+    EXPECT_EQ(pool_token_trades(chain), retired_changes);
+
+    // the pool tokens converted from are still in the token supply, but not in the supply the converter prices with
+    const int64_t pending = to_asset("397.00000000 BNTDDD").amount;
+    const auto& settings = LegacyBancorConverter::settings(CONVERTER, CONVERTER.value).get("settings"_n.value);
+    EXPECT_EQ(settings.pending_retire.value(), pending);
+    EXPECT_EQ(settings.smart_currency.amount, offset - pending);
+    EXPECT_EQ(chain.balance(RELAY, CONVERTER, BNTDDD), pending);
+    EXPECT_EQ(chain.supply(RELAY, BNTDDD), retired_supply + pending);
+
+    chain.push_action(CONVERTER, "retirepend"_n, TEST_ACCOUNT_2);
+    EXPECT_EQ(retire_actions(chain), 1);
+    EXPECT_EQ(chain.supply(RELAY, BNTDDD), retired_supply);
+    EXPECT_EQ(chain.balance(RELAY, CONVERTER, BNTDDD), 0);
+    const auto& flushed = LegacyBancorConverter::settings(CONVERTER, CONVERTER.value).get("settings"_n.value);
+    EXPECT_EQ(flushed.pending_retire.value(), 0);
+    EXPECT_EQ(flushed.smart_currency.amount, offset);
+    expect_assert([&] { chain.push_action(CONVERTER, "retirepend"_n, TEST_ACCOUNT_2); }, "no pending pool tokens to retire");
+}
+
+TEST(LegacyBancorConverter, retires_pending_pool_tokens_at_the_threshold) {
+    converter_chain chain;
+    const int64_t supply = chain.supply(RELAY, BNTDDD);
+    chain.push_action(CONVERTER, "setretire"_n, CONVERTER, int64_t(to_asset("10.00000000 BNTDDD").amount));
+
+    chain.convert(TEST_ACCOUNT_1, RELAY, to_asset("6.00000000 BNTDDD"), "bnt2dddcnvrt DDD");
+    EXPECT_EQ(retire_actions(chain), 0);
+    EXPECT_EQ(chain.supply(RELAY, BNTDDD), supply);
+
+    // the conversion that reaches the threshold retires every pending pool token
+    chain.convert(TEST_ACCOUNT_1, RELAY, to_asset("4.00000000 BNTDDD"), "bnt2dddcnvrt DDD");
+    EXPECT_EQ(retire_actions(chain), 1);
+    EXPECT_EQ(chain.supply(RELAY, BNTDDD), supply - to_asset("10.00000000 BNTDDD").amount);
+    EXPECT_EQ(chain.balance(RELAY, CONVERTER, BNTDDD), 0);
+
+    // disabling the threshold retires the pending pool tokens
+    chain.convert(TEST_ACCOUNT_1, RELAY, to_asset("1.00000000 BNTDDD"), "bnt2dddcnvrt DDD");
+    chain.push_action(CONVERTER, "setretire"_n, CONVERTER, int64_t(0));
+    EXPECT_EQ(retire_actions(chain), 1);
+    EXPECT_EQ(chain.balance(RELAY, CONVERTER, BNTDDD), 0);
+    chain.convert(TEST_ACCOUNT_1, RELAY, to_asset("1.00000000 BNTDDD"), "bnt2dddcnvrt DDD");
+    EXPECT_EQ(retire_actions(chain), 1);
+
+    expect_assert([&] { chain.push_action(CONVERTER, "setretire"_n, TEST_ACCOUNT_1, int64_t(0)); }, "missing authority");
+}
+
+namespace {
+
+// the cumulative of a row of the prices table at `now`
+double cumulative_price(symbol_code sym, uint32_t now) {
+    const auto& price = LegacyBancorConverter::prices(CONVERTER, CONVERTER.value).get(sym.raw());
+    return price.cumulative + price.log_value * (now - price.last_update);
+}
+
+} // namespace
+
+TEST(LegacyBancorConverter, accumulates_time_weighted_prices) {
+    converter_chain chain;
+    uint32_t now = 1600000000;
+    chain.set_time(now);
+    chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("1.00000000 BNT"), "bnt2dddcnvrt DDD");
+    chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("1.00000000 BNT"), "bnt2dddcnvrt BNTDDD");
+
+    // the spot prices of DDD and of the pool token in BNT, from the balances and the supply
+    const auto spot_prices = [&] {
+        const double bnt = chain.balance(BNT_TOKEN, CONVERTER, BNT);
+        const double ddd = chain.balance(RESERVE, CONVERTER, DDD);
+        return std::make_pair(bnt / ddd, 2 * bnt / chain.supply(RELAY, BNTDDD));
+    };
+
+    const uint32_t start = now;
+    const double bnt_start = cumulative_price(BNT, start), ddd_start = cumulative_price(DDD, start), smart_start = cumulative_price(BNTDDD, start);
+    double ddd_log_sum = 0, smart_log_sum = 0;
+    const vector<std::tuple<uint32_t, name, string, string>> trades = {
+        { 30, BNT_TOKEN, "50.00000000 BNT", "DDD" }, { 600, RESERVE, "20.00000000 DDD", "BNTDDD" }, { 5, RELAY, "300.00000000 BNTDDD", "BNT" },
+        { 3600, RESERVE, "60.00000000 DDD", "BNT" }, { 0, BNT_TOKEN, "10.00000000 BNT", "BNTDDD" }, { 120, BNT_TOKEN, "1.00000000 BNT", "DDD" }
+    };
+    for (const auto& [elapsed, token, quantity, to] : trades) {
+        const auto [ddd_price, smart_price] = spot_prices();
+        ddd_log_sum += log(ddd_price) * elapsed;
+        smart_log_sum += log(smart_price) * elapsed;
+        now += elapsed;
+        chain.set_time(now);
+        chain.convert(TEST_ACCOUNT_1, token, to_asset(quantity), "bnt2dddcnvrt " + to);
+    }
+    const auto [ddd_price, smart_price] = spot_prices();
+    ddd_log_sum += log(ddd_price) * 900;
+    smart_log_sum += log(smart_price) * 900;
+    now += 900;
+
+    // two reads of the table give the geometric mean of the prices in between
+    const double seconds = now - start;
+    const double bnt_change = cumulative_price(BNT, now) - bnt_start;
+    EXPECT_NEAR(exp((bnt_change - (cumulative_price(DDD, now) - ddd_start)) / seconds), exp(ddd_log_sum / seconds), 1e-9);
+    EXPECT_NEAR(exp((bnt_change - (cumulative_price(BNTDDD, now) - smart_start)) / seconds), exp(smart_log_sum / seconds), 1e-9);
+    EXPECT_NE(exp(ddd_log_sum / seconds), ddd_price);
+
+    // only the rows whose value changed are written
+    chain.set_time(now);
+    chain.convert(TEST_ACCOUNT_1, BNT_TOKEN, to_asset("1.00000000 BNT"), "bnt2dddcnvrt DDD");
+    EXPECT_EQ(LegacyBancorConverter::prices(CONVERTER, CONVERTER.value).get(BNTDDD.raw()).last_update, now - 900 - 120);
+    EXPECT_EQ(LegacyBancorConverter::prices(CONVERTER, CONVERTER.value).get(DDD.raw()).last_update, now);
+}
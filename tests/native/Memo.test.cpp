@@ -0,0 +1,134 @@
+#include "fixture.hpp"
+
+namespace {
+
+// the version 2 encoding of a version 1 memo
+string to_compact(const string& memo) {
+    memo_structure data = parse_memo(memo);
+    data.version = "2";
+    return build_memo(data);
+}
+
+void expect_same_memo(const memo_structure& a, const memo_structure& b) {
+    EXPECT_EQ(a.path, b.path);
+    ASSERT_EQ(a.converters.size(), b.converters.size());
+    for (size_t i = 0; i < a.converters.size(); i++) {
+        EXPECT_EQ(a.converters[i].account, b.converters[i].account);
+        EXPECT_EQ(a.converters[i].sym, b.converters[i].sym);
+    }
+    EXPECT_EQ(a.min_return, b.min_return);
+    EXPECT_EQ(a.dest_account, b.dest_account);
+    EXPECT_EQ(a.trader_account, b.trader_account);
+    EXPECT_EQ(a.affiliate_account, b.affiliate_account);
+    EXPECT_EQ(a.affiliate_fee, b.affiliate_fee);
+    EXPECT_EQ(a.receiver_memo, b.receiver_memo);
+}
+
+// a route registered on the network with `addroute`
+route_t network_route(uint64_t id) {
+    const LegacyBancorConverter::routes routes_table(NETWORK, NETWORK.value);
+    return routes_table.get(id);
+}
+
+} // namespace
+
+TEST(Memo, compact_memos_round_trip) {
+    for (const string memo : {
+        "1,bnt2dddcnvrt DDD,0.00000001,bnttestuser1",
+        "1,bnt2dddcnvrt DDD bnt2eeecnvrt EEE,12.5,bnttestuser1;hello, world",
+        "1,legacypools:BNTDDD BNTDDD,0,bnttestuser1,bnttestuser2",
+        "1,bnt2dddcnvrt DDD,0.0001,bnttestuser1,affiliate1,0.02",
+        "1,bnt2dddcnvrt DDD,3,bnttestuser1,bnttestuser2,affiliate1,0.02;receiver memo",
+        "1,,0.00000001,bnttestuser1",
+    }) {
+        const string compact = to_compact(memo);
+        EXPECT_EQ(compact.substr(0, 2), "2,");
+        EXPECT_LE(compact.size(), build_memo(parse_memo(memo)).size()) << compact;
+
+        const memo_structure expected = parse_memo(memo);
+        const memo_structure parsed = parse_memo(compact);
+        EXPECT_EQ(parsed.version, "2");
+        expect_same_memo(parsed, expected);
+        EXPECT_EQ(build_memo(parsed), compact);
+    }
+}
+
+TEST(Memo, route_memos_advance_their_offset) {
+    bancor_chain chain;
+    const ::path route = { "bnt2dddcnvrt", "DDD", "legacypools:BNTEEE", "EEE" };
+    chain.push_action(NETWORK, "addroute"_n, NETWORK, uint64_t(300), route);
+
+    memo_structure data = parse_memo("1,,0.00000001,bnttestuser1");
+    data.version = "2";
+    data.route_id = 300;
+    const string memo = build_memo(data);
+    EXPECT_LT(memo.size(), 24) << memo;
+
+    memo_structure parsed = parse_memo(memo);
+    EXPECT_EQ(parsed.route_id, 300);
+    EXPECT_EQ(parsed.route_offset, 0);
+    EXPECT_TRUE(parsed.path.empty());
+    resolve_route(parsed, network_route(300));
+    EXPECT_EQ(parsed.path, route);
+    EXPECT_EQ(parsed.converters[1].account, "legacypools"_n);
+    EXPECT_EQ(parsed.converters[1].sym, "BNTEEE");
+
+    // a hop removes itself from the path, the next memo only differs by its offset
+    parsed.path.erase(parsed.path.begin(), parsed.path.begin() + 2);
+    memo_structure next = parse_memo(build_memo(parsed));
+    EXPECT_EQ(build_memo(parsed).size(), memo.size());
+    EXPECT_EQ(next.route_offset, 1);
+    resolve_route(next, network_route(300));
+    EXPECT_EQ(next.path, ::path(route.begin() + 2, route.end()));
+    EXPECT_EQ(next.min_return, "0.00000001");
+
+    next.path.clear();
+    memo_structure done = parse_memo(build_memo(next));
+    resolve_route(done, network_route(300));
+    EXPECT_TRUE(done.path.empty());
+
+    done.route_offset = 3;
+    expect_assert([&] { resolve_route(done, network_route(300)); }, "invalid route offset");
+}
+
+TEST(Memo, rejects_malformed_compact_memos) {
+    const string compact = to_compact("1,bnt2dddcnvrt DDD,0.00000001,bnttestuser1");
+    expect_assert([&] { parse_memo(compact.substr(0, compact.size() - 3)); }, "invalid memo payload");
+    expect_assert([&] { parse_memo(compact + "AA"); }, "invalid memo payload");
+    expect_assert([&] { parse_memo("2,AAA*"); }, "invalid memo payload");
+    expect_assert([&] { parse_memo("2,A"); }, "invalid memo payload");
+    expect_assert([&] { parse_memo(compact + ",x"); }, "invalid memo");
+}
+
+TEST(Memo, scales_decimal_numbers) {
+    EXPECT_EQ(to_scaled_amount("14.214212", 3), 14214);
+    EXPECT_EQ(to_scaled_amount("0.00000001", 8), 1);
+    EXPECT_EQ(to_scaled_amount("12.5", 8), 1250000000);
+    EXPECT_EQ(to_scaled_amount("000000000000000000000012.5", 1), 125);
+    EXPECT_EQ(to_scaled_amount("", 4), 0);
+    EXPECT_EQ(to_scaled_amount("7.", 2), 700);
+    EXPECT_EQ(to_scaled_amount(".5", 2), 50);
+    EXPECT_EQ(to_scaled_amount("1.999999999999999999999", 0), 1);
+    EXPECT_EQ(to_scaled_amount("4611686018427387903", 0), asset::max_amount);
+    EXPECT_EQ(to_scaled_amount("46116860184.27387903", 8), asset::max_amount);
+
+    expect_assert([] { to_scaled_amount("4611686018427387904", 0); }, "decimal number is out of range");
+    expect_assert([] { to_scaled_amount("46116860184.27387904", 8); }, "decimal number is out of range");
+    expect_assert([] { to_scaled_amount("99999999999999999999", 0); }, "decimal number is out of range");
+    expect_assert([] { to_scaled_amount("1", 19); }, "decimal number is out of range");
+    for (const string invalid : { "-1", "1e5", "1.2.3", "0.0000000x", "1 ", "1,5", "12345678:" })
+        expect_assert([&] { to_scaled_amount(invalid, 8); }, "invalid decimal number");
+    // invalid digits are reported even when they would be truncated
+    expect_assert([] { to_scaled_amount("1.123456789a", 8); }, "invalid decimal number");
+}
+
+TEST(Memo, reads_versions_other_than_2_as_csv_memos) {
+    for (const string version : { "1", "01", "02", "2.0", "x" }) {
+        const string memo = version + ",bnt2dddcnvrt DDD legacypools:BNTEEE EEE,0.00000001,bnttestuser1;convert";
+        const memo_structure parsed = parse_memo(memo);
+        EXPECT_EQ(parsed.version, version);
+        EXPECT_EQ(parsed.path.size(), 4) << memo;
+        EXPECT_EQ(build_memo(parsed), memo);
+    }
+    expect_assert([] { parse_memo("1,bnt2dddcnvrt DDD,1,bnttestuser1,affiliate1,2%"); }, "invalid decimal number");
+}
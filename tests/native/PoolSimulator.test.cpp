@@ -0,0 +1,123 @@
+#include <atomic>
+#include <random>
+
+#include "fixture.hpp"
+#include "pool_simulator.hpp"
+
+using namespace simulator;
+
+namespace {
+
+legacy_converter ddd_converter() {
+    return { "bnt2dddcnvrt"_n, "bnt2dddrelay"_n, symbol("BNTDDD", 8), 1000,
+        { { BNT_TOKEN, to_asset("600.00000300 BNT"), 500000 }, { "ddd"_n, to_asset("1201.20000000 DDD"), 500000 } },
+        { { TEST_ACCOUNT_1, to_asset("12000.02009001 BNTDDD") } } };
+}
+
+// unequal ratios, so that conversions between the reserves go through the pool token
+legacy_converter weighted_converter() {
+    return { "bnt2xyzcnvrt"_n, "bnt2xyzrelay"_n, symbol("BNTXYZ", 8), 2500,
+        { { BNT_TOKEN, to_asset("8000.00000000 BNT"), 200000 }, { "xyz"_n, to_asset("31337.123456 XYZ"), 300000 } },
+        { { TEST_ACCOUNT_1, to_asset("5000.00000000 BNTXYZ") } } };
+}
+
+pool_book book_of(const bancor_chain& chain, const legacy_converter& converter) {
+    std::vector<reserve_params> reserves;
+    for (const legacy_reserve& reserve : converter.reserves)
+        reserves.push_back({ chain.balance(reserve.contract, converter.account, reserve.balance.symbol.code()), reserve.balance.symbol.precision(), reserve.ratio });
+
+    pool_book book;
+    book.add_pool(chain.supply(converter.relay, converter.relay_symbol.code()), converter.relay_symbol.precision(), converter.fee, reserves);
+    return book;
+}
+
+pool_book random_book(size_t pools, uint64_t seed) {
+    std::mt19937_64 random(seed);
+    std::uniform_int_distribution<int64_t> amount(10000000000, 100000000000000);
+
+    pool_book book;
+    for (size_t p = 0; p < pools; p++) {
+        const uint64_t ratio = 100000 + random() % 400000;
+        book.add_pool(amount(random), 8, random() % 30001, { { amount(random), 8, ratio }, { amount(random), 4, 1000000 - ratio } });
+    }
+    return book;
+}
+
+} // namespace
+
+TEST(PoolSimulator, matches_the_contract) {
+    for (const legacy_converter& converter : { ddd_converter(), weighted_converter() }) {
+        SCOPED_TRACE(converter.account.to_string());
+        bancor_chain chain;
+        chain.add_legacy_converter(converter);
+        pool_book book = book_of(chain, converter);
+
+        // the pool token is the last side, as in random_trades
+        std::vector<std::pair<name, symbol>> tokens;
+        for (const legacy_reserve& reserve : converter.reserves)
+            tokens.push_back({ reserve.contract, reserve.balance.symbol });
+        tokens.push_back({ converter.relay, converter.relay_symbol });
+
+        std::mt19937_64 random(20201019);
+        for (int i = 0; i < 1000; i++) {
+            const uint16_t from = random() % tokens.size();
+            const uint16_t to = random() % tokens.size();
+            const auto& [from_token, from_symbol] = tokens[from];
+            const int64_t holder_balance = chain.balance(from_token, TEST_ACCOUNT_1, from_symbol.code());
+            if (from == to || holder_balance < 2)
+                continue;
+
+            const int64_t quantity = 1 + random() % std::min<int64_t>(holder_balance / 2, 1000000000000);
+            const uint16_t smart = tokens.size() - 1;
+            const trade t = { from == smart ? SMART_TOKEN : from, to == smart ? SMART_TOKEN : to, quantity };
+
+            bool converted = true;
+            try {
+                chain.convert(TEST_ACCOUNT_1, from_token, asset(quantity, from_symbol), converter.account.to_string() + " " + tokens[to].second.code().to_string());
+            }
+            catch (const eosio::eosio_assert_exception&) {
+                converted = false;
+            }
+            ASSERT_EQ(execute_trade(book, 0, t), converted) << "trade " << i;
+
+            ASSERT_EQ(book.supply[0], chain.supply(converter.relay, converter.relay_symbol.code())) << "trade " << i;
+            for (size_t r = 0; r < converter.reserves.size(); r++) {
+                const legacy_reserve& reserve = converter.reserves[r];
+                ASSERT_EQ(book.balance[r], chain.balance(reserve.contract, converter.account, reserve.balance.symbol.code())) << "trade " << i;
+            }
+        }
+    }
+}
+
+TEST(PoolSimulator, parallel_runs_match_sequential_runs) {
+    pool_book sequential_book = random_book(64, 7);
+    pool_book parallel_book = sequential_book;
+
+    std::vector<std::vector<trade>> trades(sequential_book.size());
+    for (size_t p = 0; p < sequential_book.size(); p++)
+        trades[p] = random_trades(sequential_book, p, 500 + p * 20, p, 0.05);
+
+    thread_pool one_worker(1), workers(4);
+    const std::vector<pool_result> sequential = simulate(sequential_book, trades, one_worker, 10);
+    const std::vector<pool_result> parallel = simulate(parallel_book, trades, workers, 10);
+
+    for (size_t p = 0; p < sequential.size(); p++) {
+        EXPECT_EQ(sequential[p].executed, parallel[p].executed);
+        EXPECT_EQ(sequential[p].rejected, parallel[p].rejected);
+        EXPECT_EQ(sequential[p].trajectory, parallel[p].trajectory);
+        EXPECT_EQ(sequential[p].executed + sequential[p].rejected, trades[p].size());
+    }
+    EXPECT_EQ(sequential_book.balance, parallel_book.balance);
+    EXPECT_EQ(sequential_book.supply, parallel_book.supply);
+    EXPECT_EQ(sequential_book.fee_revenue, parallel_book.fee_revenue);
+}
+
+TEST(PoolSimulator, thread_pool_runs_every_task_once) {
+    thread_pool workers(4);
+    for (size_t count : { 1, 3, 1000, 20000 }) {
+        std::vector<std::atomic<int>> runs(count);
+        workers.parallel_for(count, [&](size_t i) { runs[i]++; });
+        for (size_t i = 0; i < count; i++)
+            ASSERT_EQ(runs[i], 1) << i;
+    }
+}
@@ -0,0 +1,65 @@
+/**
+ * compares check_format with the eagerly concatenated messages it replaced in init and setreserve,
+ * on passing checks (every valid action) and on failing ones (the message is formatted and the check throws)
+ *
+ * usage: check_format_bench [checks]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "fixture.hpp"
+
+namespace {
+
+void eager_check(uint64_t ratio) {
+    check(ratio > 0 && ratio <= MAX_RATIO,
+         ("ratio must be between 1 and " + std::to_string(MAX_RATIO)).c_str());
+}
+
+void lazy_check(uint64_t ratio) {
+    check_format(ratio > 0 && ratio <= MAX_RATIO, "ratio must be between 1 and {}", MAX_RATIO);
+}
+
+template <typename F>
+double measure(const vector<uint64_t>& ratios, uint64_t& failures, F&& assert_ratio) {
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t ratio : ratios) {
+        try {
+            assert_ratio(ratio);
+        }
+        catch (const eosio::eosio_assert_exception&) {
+            failures++;
+        }
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t count = argc > 1 ? std::stoull(argv[1]) : 10000000;
+    std::mt19937_64 random(20201019);
+    vector<uint64_t> valid, invalid;
+    for (size_t i = 0; i < count; i++)
+        valid.push_back(1 + random() % uint64_t(MAX_RATIO));
+    for (size_t i = 0; i < count / 100; i++)
+        invalid.push_back(uint64_t(MAX_RATIO) + 1 + random() % 1000);
+
+    uint64_t eager_failures = 0, lazy_failures = 0;
+    const double eager_seconds = measure(valid, eager_failures, eager_check);
+    const double lazy_seconds = measure(valid, lazy_failures, lazy_check);
+    const double eager_fail_seconds = measure(invalid, eager_failures, eager_check);
+    const double lazy_fail_seconds = measure(invalid, lazy_failures, lazy_check);
+
+    printf("%zu passing and %zu failing checks, failures %llu %llu\n", valid.size(), invalid.size(),
+        (unsigned long long)eager_failures, (unsigned long long)lazy_failures);
+    printf("passing, concatenated: %8.3f s %8.1f ns/check\n", eager_seconds, eager_seconds * 1e9 / valid.size());
+    printf("passing, check_format: %8.3f s %8.1f ns/check\n", lazy_seconds, lazy_seconds * 1e9 / valid.size());
+    printf("failing, concatenated: %8.3f s %8.1f ns/check\n", eager_fail_seconds, eager_fail_seconds * 1e9 / invalid.size());
+    printf("failing, check_format: %8.3f s %8.1f ns/check\n", lazy_fail_seconds, lazy_fail_seconds * 1e9 / invalid.size());
+    printf("speedup on passing checks: %.1fx\n", eager_seconds / lazy_seconds);
+    return eager_failures == lazy_failures ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+// the contracts are compiled into this unit, the same way eosio-cpp builds each of them from its source file
+#include "../../src/LegacyBancorConverter/LegacyBancorConverter.cpp"
+#include "../../src/BancorConverterMigration/BancorConverterMigration.cpp"
+#include "mocks/BancorNetwork.hpp"
+
+#include "contracts.hpp"
+
+namespace eosio_mock {
+
+apply_handler token_contract() {
+    return dispatcher<Token>()
+        .action("create"_n, &Token::create)
+        .action("issue"_n, &Token::issue)
+        .action("retire"_n, &Token::retire)
+        .action("transfer"_n, &Token::transfer)
+        .action("open"_n, &Token::open)
+        .action("close"_n, &Token::close);
+}
+
+apply_handler network_contract() {
+    return dispatcher<BancorNetwork>()
+        .action("addroute"_n, &BancorNetwork::addroute)
+        .on_notify("transfer"_n, &BancorNetwork::on_transfer);
+}
+
+apply_handler multi_converter_contract() {
+    return dispatcher<BancorConverter>()
+        .action("setmultitokn"_n, &BancorConverter::setmultitokn)
+        .action("setmaxfee"_n, &BancorConverter::setmaxfee)
+        .action("setnetwork"_n, &BancorConverter::setnetwork)
+        .action("create"_n, &BancorConverter::create)
+        .action("updateowner"_n, &BancorConverter::updateowner)
+        .action("updatefee"_n, &BancorConverter::updatefee)
+        .action("setreserve"_n, &BancorConverter::setreserve)
+        .action("withdraw"_n, &BancorConverter::withdraw)
+        .action("fund"_n, &BancorConverter::fund)
+        .on_notify("transfer"_n, &BancorConverter::on_transfer);
+}
+
+apply_handler legacy_converter_contract() {
+    return dispatcher<LegacyBancorConverter>()
+        .action("init"_n, &LegacyBancorConverter::init)
+        .action("update"_n, &LegacyBancorConverter::update)
+        .action("setpoolevent"_n, &LegacyBancorConverter::setpoolevent)
+        .action("setretire"_n, &LegacyBancorConverter::setretire)
+        .action("retirepend"_n, &LegacyBancorConverter::retirepend)
+        .action("setreserve"_n, &LegacyBancorConverter::setreserve)
+        .action("delreserve"_n, &LegacyBancorConverter::delreserve)
+        .action("convertbatch"_n, &LegacyBancorConverter::convertbatch)
+        .action("refund"_n, &LegacyBancorConverter::refund)
+        .on_notify("transfer"_n, &LegacyBancorConverter::on_transfer);
+}
+
+apply_handler migration_contract() {
+    return dispatcher<BancorConverterMigration>()
+        .action("setsettings"_n, &BancorConverterMigration::setsettings)
+        .action("addconverter"_n, &BancorConverterMigration::addconverter)
+        .action("addconverters"_n, &BancorConverterMigration::addconverters)
+        .action("delconverter"_n, &BancorConverterMigration::delconverter)
+        .action("rescope"_n, &BancorConverterMigration::rescope)
+        .action("refreshsym"_n, &BancorConverterMigration::refreshsym)
+        .action("fundexisting"_n, &BancorConverterMigration::fundexisting)
+        .action("fundnew"_n, &BancorConverterMigration::fundnew)
+        .action("previewmig"_n, &BancorConverterMigration::previewmig)
+        .action("migstep"_n, &BancorConverterMigration::migstep)
+        .action("cancelmig"_n, &BancorConverterMigration::cancelmig)
+        .action("finalize"_n, &BancorConverterMigration::finalize)
+        .action("assertsucess"_n, &BancorConverterMigration::assertsucess)
+        .on_notify("transfer"_n, &BancorConverterMigration::on_transfer);
+}
+
+} // namespace eosio_mock
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "harness.hpp"
+
+/// handlers of the contracts that can be deployed on the native test chain
+namespace eosio_mock {
+
+apply_handler token_contract();
+apply_handler network_contract();
+apply_handler multi_converter_contract();
+apply_handler legacy_converter_contract();
+apply_handler migration_contract();
+
+} // namespace eosio_mock
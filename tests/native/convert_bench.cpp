@@ -0,0 +1,65 @@
+/**
+ * runs conversions through each branch of the legacy converter on the native test chain,
+ * and reports the external table reads (token balances and supply) of the converter per conversion
+ *
+ * usage: convert_bench [conversions per branch]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "fixture.hpp"
+
+namespace {
+
+const name CONVERTER = "bnt2dddcnvrt"_n;
+const name RELAY = "bnt2dddrelay"_n;
+const name RESERVE = "ddd"_n;
+const name EEE_RESERVE = "eee"_n;
+
+struct branch {
+    const char* label;
+    name token;
+    const char* quantity;
+    const char* path;
+};
+
+// the reserves have equal ratios except EEE, so every branch of calculate_conversion_return is covered
+const branch BRANCHES[] = {
+    { "reserve -> reserve, equal ratios", BNT_TOKEN, "1.00000000 BNT", "bnt2dddcnvrt DDD" },
+    { "reserve -> reserve, cross ratios", BNT_TOKEN, "1.00000000 BNT", "bnt2dddcnvrt EEE" },
+    { "reserve -> pool token", BNT_TOKEN, "1.00000000 BNT", "bnt2dddcnvrt BNTDDD" },
+    { "pool token -> reserve", RELAY, "1.00000000 BNTDDD", "bnt2dddcnvrt DDD" },
+};
+
+class bench_chain : public bancor_chain {
+    public:
+        bench_chain() {
+            add_legacy_converter({ CONVERTER, RELAY, symbol("BNTDDD", 8), 1000,
+                { { BNT_TOKEN, to_asset("600000.00000300 BNT"), 400000 }, { RESERVE, to_asset("1201000.20000000 DDD"), 400000 },
+                  { EEE_RESERVE, to_asset("300000.00000000 EEE"), 200000 } },
+                { { TEST_ACCOUNT_1, to_asset("12000000.02009001 BNTDDD") } } });
+        }
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t count = argc > 1 ? std::stoull(argv[1]) : 10000;
+    bench_chain chain;
+
+    printf("%-34s %12s %10s %10s\n", "branch", "us/convert", "accounts", "stat");
+    for (const branch& b : BRANCHES) {
+        uint64_t accounts = 0, stat = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; i++) {
+            chain.convert(TEST_ACCOUNT_1, b.token, to_asset(b.quantity), b.path);
+            accounts += chain.db_reads(CONVERTER, "accounts"_n);
+            stat += chain.db_reads(CONVERTER, "stat"_n);
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("%-34s %12.2f %10.2f %10.2f\n", b.label, seconds * 1e6 / count, double(accounts) / count, double(stat) / count);
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+/**
+ * compares curve_power with the pow call it replaced, for the linear (100%) and square root (50%) kernels,
+ * and for any other ratio, where curve_power is pow itself, on random purchases and sales of up to a tenth of the reserve
+ *
+ * usage: curve_bench [evaluations]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#include "fixture.hpp"
+
+namespace {
+
+template <typename F>
+double measure(const vector<double>& shares, double& checksum, F&& power) {
+    const auto start = std::chrono::steady_clock::now();
+    for (double x : shares)
+        checksum += power(x);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t count = argc > 1 ? std::stoull(argv[1]) : 10000000;
+    std::mt19937_64 random(20201019);
+    std::uniform_real_distribution<double> share(0, 0.1);
+    vector<double> shares;
+    for (size_t i = 0; i < count; i++)
+        shares.push_back(share(random));
+
+    printf("%-12s %-8s %12s %12s %8s\n", "kernel", "side", "pow ns", "kernel ns", "speedup");
+    for (uint64_t ratio : { 1000000, 500000, 250000 }) {
+        const curve_coefficients curve = make_curve_coefficients(ratio);
+        const char* label = ratio == 1000000 ? "linear" : ratio == 500000 ? "square root" : "generic";
+        for (bool sale : { false, true }) {
+            const double exponent = sale ? MAX_RATIO / ratio : ratio / MAX_RATIO;
+            const double sign = sale ? -1.0 : 1.0;
+            double pow_checksum = 0, kernel_checksum = 0;
+            const double pow_seconds = measure(shares, pow_checksum, [&](double x) { return pow(1.0 + sign * x, exponent); });
+            const double kernel_seconds = measure(shares, kernel_checksum, [&](double x) { return curve_power(sign * x, curve, sale); });
+            printf("%-12s %-8s %12.2f %12.2f %7.1fx  checksums %.6f %.6f\n", label, sale ? "sale" : "purchase",
+                pow_seconds * 1e9 / count, kernel_seconds * 1e9 / count, pow_seconds / kernel_seconds, pow_checksum, kernel_checksum);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,96 @@
+/**
+ * compares to_scaled_amount with the float (stof) and 7 digit (stoui) parsers the memo fields went through before,
+ * on random min return strings
+ *
+ * usage: decimal_bench [values]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "fixture.hpp"
+
+namespace {
+
+float stof(const char* s) {
+    float rez = 0, fact = 1;
+
+    if (*s == '-') {
+        s++;
+        fact = -1;
+    }
+    for (int point_seen = 0; *s; s++) {
+        if (*s == '.') {
+            if (point_seen) return 0;
+            point_seen = 1;
+            continue;
+        }
+        int d = *s - '0';
+        if (d >= 0 && d <= 9) {
+            if (point_seen) fact /= 10.0f;
+            rez = rez * 10.0f + (float)d;
+        } else return 0;
+    }
+    return rez * fact;
+}
+
+uint64_t stoui(string const& value) {
+    uint64_t result = 0;
+    size_t const length = value.size();
+    switch (length) {
+        case 7: result += (value[length -  7] - '0') * 1000000ULL;
+        case 6: result += (value[length -  6] - '0') * 100000ULL;
+        case 5: result += (value[length -  5] - '0') * 10000ULL;
+        case 4: result += (value[length -  4] - '0') * 1000ULL;
+        case 3: result += (value[length -  3] - '0') * 100ULL;
+        case 2: result += (value[length -  2] - '0') * 10ULL;
+        case 1: result += (value[length -  1] - '0');
+    }
+    return result;
+}
+
+// min returns of 8 decimal tokens, as wallets print them
+vector<string> random_values(size_t count) {
+    std::mt19937_64 random(20201019);
+    vector<string> values;
+    values.reserve(count);
+    char buf[32];
+    for (size_t i = 0; i < count; i++) {
+        const uint64_t amount = random() % 100000000000000ULL;
+        snprintf(buf, sizeof(buf), "%llu.%08llu", (unsigned long long)(amount / 100000000), (unsigned long long)(amount % 100000000));
+        values.push_back(buf);
+    }
+    return values;
+}
+
+template <typename F>
+double measure(const vector<string>& values, double& checksum, F&& parse) {
+    const auto start = std::chrono::steady_clock::now();
+    for (const string& value : values)
+        checksum += parse(value);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t count = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    const vector<string> values = random_values(count);
+
+    double scaled = 0, floats = 0, integers = 0;
+    const double scaled_seconds = measure(values, scaled, [](const string& v) { return to_scaled_amount(v, 8); });
+    const double stof_seconds = measure(values, floats, [](const string& v) { return stof(v.c_str()) * 1e8; });
+    const double stoui_seconds = measure(values, integers, [](const string& v) { return stoui(v); });
+
+    size_t float_errors = 0;
+    for (const string& value : values)
+        float_errors += int64_t(stof(value.c_str()) * 1e8 + 0.5) != to_scaled_amount(value, 8);
+
+    printf("%zu values, checksums %.0f %.0f %.0f\n", count, scaled, floats, integers);
+    printf("to_scaled_amount: %8.3f s %8.1f ns/value\n", scaled_seconds, scaled_seconds * 1e9 / count);
+    printf("stof:             %8.3f s %8.1f ns/value, %zu values off by at least one unit\n", stof_seconds, stof_seconds * 1e9 / count, float_errors);
+    printf("stoui:            %8.3f s %8.1f ns/value, only reads the last 7 digits\n", stoui_seconds, stoui_seconds * 1e9 / count);
+    return 0;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <any>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "chain.hpp"
+#include "name.hpp"
+
+namespace eosio {
+
+struct action {
+    std::vector<permission_level> authorization;
+    eosio::name account;
+    eosio::name name;
+    std::any data;
+
+    action() = default;
+    template <typename T>
+    action(const permission_level& auth, struct name a, struct name n, T&& value)
+        : authorization{auth}, account(a), name(n), data(std::decay_t<T>(std::forward<T>(value))) {}
+    template <typename T>
+    action(const std::vector<permission_level>& auths, struct name a, struct name n, T&& value)
+        : authorization(auths), account(a), name(n), data(std::decay_t<T>(std::forward<T>(value))) {}
+
+    void send() const {
+        eosio_mock::chain().inline_actions.push_back(eosio_mock::pending_action{account, name, authorization, data});
+    }
+};
+
+template <name::raw Name, auto Action>
+struct action_wrapper {
+    template <typename Code>
+    action_wrapper(Code&& c, const permission_level& p) : code_name(std::forward<Code>(c)), permissions{p} {}
+    template <typename... Args>
+    action to_action(Args&&... args) const {
+        return action(permissions[0], code_name, name(Name), std::make_tuple(std::forward<Args>(args)...));
+    }
+    template <typename... Args>
+    void send(Args&&... args) const { to_action(std::forward<Args>(args)...).send(); }
+    name code_name;
+    std::vector<permission_level> permissions;
+};
+
+} // namespace eosio
@@ -0,0 +1,33 @@
+#pragma once
+#include <optional>
+#include <utility>
+#include "check.hpp"
+
+namespace eosio {
+
+template <typename T>
+class binary_extension {
+public:
+    constexpr binary_extension() {}
+    constexpr binary_extension(const T& v) : _value(v) {}
+    constexpr binary_extension(T&& v) : _value(std::move(v)) {}
+
+    constexpr bool has_value() const { return _value.has_value(); }
+    constexpr T& value() & { check(has_value(), "cannot get value of empty binary_extension"); return *_value; }
+    constexpr const T& value() const& { check(has_value(), "cannot get value of empty binary_extension"); return *_value; }
+    template <typename U>
+    constexpr T value_or(U&& def) const { return _value.has_value() ? *_value : static_cast<T>(std::forward<U>(def)); }
+    constexpr T value_or() const { return _value.has_value() ? *_value : T{}; }
+    constexpr T* operator->() { return &value(); }
+    constexpr const T* operator->() const { return &value(); }
+    constexpr T& operator*() & { return value(); }
+    constexpr const T& operator*() const& { return value(); }
+    template <typename... Args>
+    T& emplace(Args&&... args) { _value.emplace(std::forward<Args>(args)...); return *_value; }
+    void reset() { _value.reset(); }
+
+private:
+    std::optional<T> _value;
+};
+
+} // namespace eosio
@@ -0,0 +1,71 @@
+#pragma once
+#include <any>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "name.hpp"
+
+namespace eosio {
+
+struct permission_level {
+    permission_level() {}
+    permission_level(name a, name p) : actor(a), permission(p) {}
+    name actor;
+    name permission;
+};
+
+} // namespace eosio
+
+/// in-memory chain state shared by the mocked eosio headers
+namespace eosio_mock {
+
+struct table_id {
+    uint64_t code;
+    uint64_t scope;
+    uint64_t table;
+    friend bool operator<(const table_id& a, const table_id& b) {
+        return std::tie(a.code, a.scope, a.table) < std::tie(b.code, b.scope, b.table);
+    }
+};
+
+/// type erased rows of a table, `clone` deep copies them for the transaction snapshots
+struct table_slot {
+    std::shared_ptr<void> rows;
+    std::shared_ptr<void> (*clone)(const std::shared_ptr<void>& rows) = nullptr;
+};
+
+struct pending_action {
+    eosio::name account;
+    eosio::name name;
+    std::vector<eosio::permission_level> authorization;
+    std::any data;
+};
+
+struct chain_state {
+    std::map<table_id, table_slot> tables;
+    std::set<uint64_t> accounts;
+    std::string console;
+    uint32_t now = 1600000000;
+
+    /// context of the action being executed
+    std::set<uint64_t> auths;
+    std::vector<eosio::name> notified;
+    std::vector<pending_action> inline_actions;
+
+    /// primitive database accesses, keyed by table name
+    std::map<uint64_t, uint64_t> db_reads;
+    std::map<uint64_t, uint64_t> db_writes;
+
+    void reset() { *this = chain_state(); }
+};
+
+inline chain_state& chain() {
+    static chain_state state;
+    return state;
+}
+
+} // namespace eosio_mock
@@ -0,0 +1,25 @@
+#pragma once
+#include <stdexcept>
+#include <string>
+#include <cstdint>
+
+namespace eosio {
+
+struct eosio_assert_exception : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+inline void check(bool pred, const char* msg) {
+    if (!pred) throw eosio_assert_exception(msg);
+}
+inline void check(bool pred, const std::string& msg) {
+    if (!pred) throw eosio_assert_exception(msg);
+}
+inline void check(bool pred, const char* msg, size_t n) {
+    if (!pred) throw eosio_assert_exception(std::string(msg, n));
+}
+inline void check(bool pred, uint64_t code) {
+    if (!pred) throw eosio_assert_exception("error code: " + std::to_string(code));
+}
+
+} // namespace eosio
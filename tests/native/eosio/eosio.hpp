@@ -0,0 +1,23 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "action.hpp"
+#include "asset.hpp"
+#include "binary_extension.hpp"
+#include "check.hpp"
+#include "contract.hpp"
+#include "datastream.hpp"
+#include "multi_index.hpp"
+#include "name.hpp"
+#include "print.hpp"
+#include "symbol.hpp"
+#include "system.hpp"
+
+#define ACTION [[eosio::action]] void
+#define TABLE struct [[eosio::table]]
+#define CONTRACT class [[eosio::contract]]
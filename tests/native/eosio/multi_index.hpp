@@ -0,0 +1,228 @@
+#pragma once
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+#include "chain.hpp"
+#include "check.hpp"
+#include "name.hpp"
+
+namespace eosio {
+
+template <name::raw IndexName, typename Extractor>
+struct indexed_by {
+    static constexpr name::raw index_name = IndexName;
+    using extractor = Extractor;
+};
+
+template <class Class, typename Type, Type (Class::*PtrToMemberFunction)() const>
+struct const_mem_fun {
+    using result_type = Type;
+    Type operator()(const Class& c) const { return (c.*PtrToMemberFunction)(); }
+};
+
+namespace _multi_index_detail {
+
+template <typename T>
+struct table_rows {
+    std::map<uint64_t, std::unique_ptr<T>> rows;
+
+    static std::shared_ptr<void> clone(const std::shared_ptr<void>& other) {
+        auto copy = std::make_shared<table_rows<T>>();
+        for (const auto& [pk, row] : static_cast<const table_rows<T>*>(other.get())->rows)
+            copy->rows.emplace(pk, std::make_unique<T>(*row));
+        return copy;
+    }
+};
+
+template <name::raw Name, typename... Indices>
+struct find_index;
+
+template <name::raw Name>
+struct find_index<Name> {
+    using type = void;
+};
+
+template <name::raw Name, typename First, typename... Rest>
+struct find_index<Name, First, Rest...> {
+    using type = std::conditional_t<First::index_name == Name, First, typename find_index<Name, Rest...>::type>;
+};
+
+} // namespace _multi_index_detail
+
+template <name::raw TableName, typename T, typename... Indices>
+class multi_index {
+    using rows_t = std::map<uint64_t, std::unique_ptr<T>>;
+
+    rows_t& rows() const {
+        auto& tables = eosio_mock::chain().tables;
+        auto& slot = tables[eosio_mock::table_id{_code.value, _scope, static_cast<uint64_t>(TableName)}];
+        if (!slot.rows) {
+            slot.rows = std::make_shared<_multi_index_detail::table_rows<T>>();
+            slot.clone = &_multi_index_detail::table_rows<T>::clone;
+        }
+        return static_cast<_multi_index_detail::table_rows<T>*>(slot.rows.get())->rows;
+    }
+    static void count_read() { eosio_mock::chain().db_reads[static_cast<uint64_t>(TableName)]++; }
+    static void count_write() { eosio_mock::chain().db_writes[static_cast<uint64_t>(TableName)]++; }
+
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = const T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() {}
+        const_iterator(const rows_t* r, typename rows_t::const_iterator it) : _rows(r), _it(it) {}
+        const T& operator*() const { check(_it != _rows->end(), "cannot dereference end iterator"); return *_it->second; }
+        const T* operator->() const { return &**this; }
+        const_iterator& operator++() { count_read(); ++_it; return *this; }
+        const_iterator operator++(int) { auto t = *this; ++*this; return t; }
+        const_iterator& operator--() { count_read(); --_it; return *this; }
+        const_iterator operator--(int) { auto t = *this; --*this; return t; }
+        friend bool operator==(const const_iterator& a, const const_iterator& b) { return a._it == b._it; }
+        friend bool operator!=(const const_iterator& a, const const_iterator& b) { return a._it != b._it; }
+        typename rows_t::const_iterator _raw() const { return _it; }
+    private:
+        const rows_t* _rows = nullptr;
+        typename rows_t::const_iterator _it;
+    };
+
+    template <typename Index>
+    class secondary_index {
+        using key_type = typename Index::extractor::result_type;
+        using entry = std::pair<key_type, const T*>;
+    public:
+        class const_iterator {
+        public:
+            const_iterator() {}
+            const_iterator(std::shared_ptr<std::vector<entry>> e, size_t p) : _entries(e), _pos(p) {}
+            const T& operator*() const { check(_pos < _entries->size(), "cannot dereference end iterator"); return *(*_entries)[_pos].second; }
+            const T* operator->() const { return &**this; }
+            const_iterator& operator++() { count_read(); ++_pos; return *this; }
+            const_iterator& operator--() { count_read(); --_pos; return *this; }
+            friend bool operator==(const const_iterator& a, const const_iterator& b) { return a._pos == b._pos; }
+            friend bool operator!=(const const_iterator& a, const const_iterator& b) { return a._pos != b._pos; }
+        private:
+            std::shared_ptr<std::vector<entry>> _entries;
+            size_t _pos = 0;
+        };
+
+        explicit secondary_index(const rows_t& rows) : _entries(std::make_shared<std::vector<entry>>()) {
+            typename Index::extractor ex;
+            for (const auto& [pk, row] : rows) _entries->emplace_back(ex(*row), row.get());
+            std::stable_sort(_entries->begin(), _entries->end(), [](const entry& a, const entry& b) { return a.first < b.first; });
+        }
+        const_iterator begin() const { count_read(); return const_iterator(_entries, 0); }
+        const_iterator end() const { return const_iterator(_entries, _entries->size()); }
+        const_iterator lower_bound(const key_type& k) const {
+            count_read();
+            auto it = std::lower_bound(_entries->begin(), _entries->end(), k, [](const entry& e, const key_type& v) { return e.first < v; });
+            return const_iterator(_entries, it - _entries->begin());
+        }
+        const_iterator upper_bound(const key_type& k) const {
+            count_read();
+            auto it = std::upper_bound(_entries->begin(), _entries->end(), k, [](const key_type& v, const entry& e) { return v < e.first; });
+            return const_iterator(_entries, it - _entries->begin());
+        }
+        const_iterator find(const key_type& k) const {
+            auto it = lower_bound(k);
+            if (it != end() && typename Index::extractor()(*it) == k) return it;
+            return end();
+        }
+        const T& get(const key_type& k, const char* msg = "unable to find secondary key") const {
+            auto it = find(k);
+            check(it != end(), msg);
+            return *it;
+        }
+    private:
+        std::shared_ptr<std::vector<entry>> _entries;
+    };
+
+    multi_index(name code, uint64_t scope) : _code(code), _scope(scope) {}
+
+    name get_code() const { return _code; }
+    uint64_t get_scope() const { return _scope; }
+
+    const_iterator begin() const { count_read(); auto& r = rows(); return const_iterator(&r, r.cbegin()); }
+    const_iterator end() const { auto& r = rows(); return const_iterator(&r, r.cend()); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    const_iterator find(uint64_t pk) const {
+        count_read();
+        auto& r = rows();
+        return const_iterator(&r, r.find(pk));
+    }
+    const_iterator require_find(uint64_t pk, const char* msg = "unable to find key") const {
+        auto it = find(pk);
+        check(it != end(), msg);
+        return it;
+    }
+    const T& get(uint64_t pk, const char* msg = "unable to find key") const {
+        auto it = find(pk);
+        check(it != end(), msg);
+        return *it;
+    }
+    const_iterator lower_bound(uint64_t pk) const { count_read(); auto& r = rows(); return const_iterator(&r, r.lower_bound(pk)); }
+    const_iterator upper_bound(uint64_t pk) const { count_read(); auto& r = rows(); return const_iterator(&r, r.upper_bound(pk)); }
+    const_iterator iterator_to(const T& obj) const { return find(obj.primary_key()); }
+
+    uint64_t available_primary_key() const {
+        auto& r = rows();
+        return r.empty() ? 0 : r.rbegin()->first + 1;
+    }
+
+    template <typename Lambda>
+    const_iterator emplace(name payer, Lambda&& constructor) {
+        count_write();
+        auto row = std::make_unique<T>();
+        constructor(*row);
+        uint64_t pk = row->primary_key();
+        auto& r = rows();
+        check(r.find(pk) == r.end(), "could not insert object, most likely a uniqueness constraint was violated");
+        auto it = r.emplace(pk, std::move(row)).first;
+        return const_iterator(&r, it);
+    }
+
+    template <typename Lambda>
+    void modify(const_iterator itr, name payer, Lambda&& updater) {
+        check(itr != end(), "cannot pass end iterator to modify");
+        modify(*itr, payer, std::forward<Lambda>(updater));
+    }
+    template <typename Lambda>
+    void modify(const T& obj, name payer, Lambda&& updater) {
+        count_write();
+        auto& mutable_obj = const_cast<T&>(obj);
+        uint64_t pk = obj.primary_key();
+        updater(mutable_obj);
+        check(pk == mutable_obj.primary_key(), "updater cannot change primary key when modifying an object");
+    }
+
+    const_iterator erase(const_iterator itr) {
+        check(itr != end(), "cannot pass end iterator to erase");
+        count_write();
+        auto& r = rows();
+        auto next = r.erase(itr._raw());
+        return const_iterator(&r, next);
+    }
+    void erase(const T& obj) { erase(find(obj.primary_key())); }
+
+    template <name::raw IndexName>
+    auto get_index() const {
+        using index_t = typename _multi_index_detail::find_index<IndexName, Indices...>::type;
+        static_assert(!std::is_void_v<index_t>, "name not found in indices");
+        return secondary_index<index_t>(rows());
+    }
+
+private:
+    name _code;
+    uint64_t _scope;
+};
+
+} // namespace eosio
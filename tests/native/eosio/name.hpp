@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace eosio {
+
+struct name {
+    enum class raw : uint64_t {};
+    uint64_t value = 0;
+
+    constexpr name() = default;
+    constexpr explicit name(uint64_t v) : value(v) {}
+    constexpr name(raw r) : value(static_cast<uint64_t>(r)) {}
+    constexpr explicit name(std::string_view str) : value(0) {
+        if (str.size() > 13) throw "string is too long to be a valid name";
+        if (str.empty()) return;
+        auto n = str.size() < 12 ? str.size() : 12;
+        for (size_t i = 0; i < n; ++i) {
+            value <<= 5;
+            value |= char_to_value(str[i]);
+        }
+        value <<= (4 + 5 * (12 - n));
+        if (str.size() == 13) {
+            // truncated to 4 bits like the legacy string_to_name, so that actions such as "addconverters" still dispatch
+            value |= char_to_value(str[12]) & 0x0Full;
+        }
+    }
+    constexpr explicit name(const char* str) : name(std::string_view(str)) {}
+    explicit name(const std::string& str) : name(std::string_view(str)) {}
+
+    static constexpr uint8_t char_to_value(char c) {
+        if (c == '.') return 0;
+        if (c >= '1' && c <= '5') return (c - '1') + 1;
+        if (c >= 'a' && c <= 'z') return (c - 'a') + 6;
+        throw "character is not in allowed character set for names";
+    }
+
+    constexpr operator raw() const { return raw(value); }
+    constexpr explicit operator bool() const { return value != 0; }
+
+    std::string to_string() const {
+        static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+        std::string str(13, '.');
+        uint64_t tmp = value;
+        for (uint32_t i = 0; i <= 12; ++i) {
+            char c = charmap[tmp & (i == 0 ? 0x0f : 0x1f)];
+            str[12 - i] = c;
+            tmp >>= (i == 0 ? 4 : 5);
+        }
+        while (!str.empty() && str.back() == '.') str.pop_back();
+        return str;
+    }
+
+    friend constexpr bool operator==(const name& a, const name& b) { return a.value == b.value; }
+    friend constexpr bool operator!=(const name& a, const name& b) { return a.value != b.value; }
+    friend constexpr bool operator<(const name& a, const name& b) { return a.value < b.value; }
+};
+
+inline constexpr name same_payer{};
+
+} // namespace eosio
+
+typedef unsigned __int128 uint128_t;
+typedef __int128 int128_t;
+
+constexpr eosio::name operator""_n(const char* s, std::size_t n) {
+    return eosio::name(std::string_view(s, n));
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdio>
+#include <string>
+#include <type_traits>
+#include "asset.hpp"
+#include "chain.hpp"
+
+namespace eosio {
+
+inline void printn(const char* s) { eosio_mock::chain().console += s; }
+inline void print_one(const char* s) { eosio_mock::chain().console += s; }
+inline void print_one(const std::string& s) { eosio_mock::chain().console += s; }
+inline void print_one(char c) { eosio_mock::chain().console += c; }
+inline void print_one(bool b) { eosio_mock::chain().console += b ? "true" : "false"; }
+// printdf formatting, e.g. 1.20000000000000000e+01
+inline void print_one(double d) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.17e", d);
+    eosio_mock::chain().console += buf;
+}
+inline void print_one(float f) { print_one(double(f)); }
+inline void print_one(name n) { eosio_mock::chain().console += n.to_string(); }
+inline void print_one(symbol_code s) { eosio_mock::chain().console += s.to_string(); }
+inline void print_one(symbol s) { eosio_mock::chain().console += s.to_string(); }
+inline void print_one(const asset& a) { eosio_mock::chain().console += a.to_string(); }
+template <typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char>, int> = 0>
+inline void print_one(T v) { eosio_mock::chain().console += std::to_string(v); }
+
+template <typename... Args>
+inline void print(Args&&... args) { (print_one(std::forward<Args>(args)), ...); }
+
+} // namespace eosio
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include "chain.hpp"
+#include "check.hpp"
+
+namespace eosio {
+
+class microseconds {
+public:
+    explicit microseconds(int64_t c = 0) : _count(c) {}
+    int64_t count() const { return _count; }
+private:
+    int64_t _count;
+};
+
+class time_point {
+public:
+    explicit time_point(microseconds e = microseconds()) : elapsed(e) {}
+    const microseconds& time_since_epoch() const { return elapsed; }
+    uint32_t sec_since_epoch() const { return uint32_t(elapsed.count() / 1000000); }
+    microseconds elapsed;
+};
+
+class time_point_sec {
+public:
+    time_point_sec() : utc_seconds(0) {}
+    explicit time_point_sec(uint32_t seconds) : utc_seconds(seconds) {}
+    time_point_sec(const time_point& t) : utc_seconds(t.sec_since_epoch()) {}
+    uint32_t sec_since_epoch() const { return utc_seconds; }
+    uint32_t utc_seconds;
+};
+
+inline time_point current_time_point() {
+    return time_point(microseconds(int64_t(eosio_mock::chain().now) * 1000000));
+}
+
+inline void require_auth(name n) {
+    check(eosio_mock::chain().auths.count(n.value) > 0, "missing authority of " + n.to_string());
+}
+inline void require_recipient(name n) { eosio_mock::chain().notified.push_back(n); }
+template <typename... Names>
+inline void require_recipient(name n, Names... names) {
+    require_recipient(n);
+    require_recipient(names...);
+}
+inline bool has_auth(name n) { return eosio_mock::chain().auths.count(n.value) > 0; }
+inline bool is_account(name n) { return eosio_mock::chain().accounts.count(n.value) > 0; }
+
+} // namespace eosio
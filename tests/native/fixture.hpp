@@ -0,0 +1,182 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../../src/BancorConverterMigration/BancorConverterMigration.hpp"
+#include "../../src/LegacyBancorConverter/LegacyBancorConverter.hpp"
+#include "../../src/includes/BancorConverter.hpp"
+#include "../../src/includes/Token.hpp"
+#include "contracts.hpp"
+
+/**
+ * the accounts and contracts that scripts/deploy.sh sets up on a local chain, on the native test chain
+ */
+
+inline const name BNT_TOKEN = "bntbntbntbnt"_n;
+inline const name NETWORK = "thisisbancor"_n;
+inline const name MULTI_CONVERTER = "multiconvert"_n;
+inline const name MULTI_TOKEN = "multi4tokens"_n;
+inline const name MIGRATION = "migration"_n;
+inline const name TEST_ACCOUNT_1 = "bnttestuser1"_n;
+inline const name TEST_ACCOUNT_2 = "bnttestuser2"_n;
+
+// parses "1.2000 ABC" into an asset
+inline asset to_asset(const string& value) {
+    const size_t space = value.find(' ');
+    const size_t point = value.find('.');
+    const uint8_t precision = point == string::npos || point > space ? 0 : space - point - 1;
+    return asset(to_scaled_amount(value.substr(0, space), precision), symbol(symbol_code(value.substr(space + 1)), precision));
+}
+
+struct legacy_reserve {
+    name contract;
+    asset balance;
+    uint64_t ratio;
+};
+
+struct legacy_converter {
+    name account;
+    name relay;
+    symbol relay_symbol;
+    uint64_t fee;
+    vector<legacy_reserve> reserves; // BNT reserves are funded from TEST_ACCOUNT_1, the rest are issued by their token
+    vector<std::pair<name, asset>> holders;
+};
+
+class bancor_chain : public eosio_mock::test_chain {
+    public:
+        bancor_chain() {
+            set_contract(BNT_TOKEN, eosio_mock::token_contract());
+            set_contract(NETWORK, eosio_mock::network_contract());
+            set_contract(MULTI_CONVERTER, eosio_mock::multi_converter_contract());
+            set_contract(MULTI_TOKEN, eosio_mock::token_contract());
+            set_contract(MIGRATION, eosio_mock::migration_contract());
+            create_account(TEST_ACCOUNT_1);
+            create_account(TEST_ACCOUNT_2);
+
+            push_action(BNT_TOKEN, "create"_n, BNT_TOKEN, BNT_TOKEN, to_asset("250000000.00000000 BNT"));
+            push_action(BNT_TOKEN, "issue"_n, BNT_TOKEN, BNT_TOKEN, to_asset("100000000.00000000 BNT"), "");
+            push_action(BNT_TOKEN, "transfer"_n, BNT_TOKEN, BNT_TOKEN, TEST_ACCOUNT_1, to_asset("100000000.00000000 BNT"), "");
+
+            push_action(MULTI_CONVERTER, "setmultitokn"_n, MULTI_CONVERTER, MULTI_TOKEN);
+            push_action(MULTI_CONVERTER, "setmaxfee"_n, MULTI_CONVERTER, uint64_t(30000));
+            push_action(MULTI_CONVERTER, "setnetwork"_n, MULTI_CONVERTER, NETWORK);
+
+            push_action(MIGRATION, "setsettings"_n, MIGRATION, MULTI_CONVERTER, MULTI_TOKEN, NETWORK);
+        }
+
+        void add_legacy_converter(const legacy_converter& converter) {
+            set_contract(converter.account, eosio_mock::legacy_converter_contract());
+            create_pool_token(converter);
+
+            push_action(converter.account, "init"_n, converter.account,
+                converter.relay, asset(0, converter.relay_symbol), true, true, NETWORK, false, uint64_t(30000), converter.fee);
+
+            for (const legacy_reserve& reserve : converter.reserves) {
+                if (reserve.contract != BNT_TOKEN)
+                    set_contract(reserve.contract, eosio_mock::token_contract());
+                push_action(converter.account, "setreserve"_n, converter.account, reserve.contract, reserve.balance.symbol, reserve.ratio, true);
+                if (reserve.contract == BNT_TOKEN) {
+                    push_action(BNT_TOKEN, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, converter.account, reserve.balance, "setup");
+                    continue;
+                }
+                push_action(reserve.contract, "create"_n, reserve.contract, converter.account, asset(asset::max_amount / 2, reserve.balance.symbol));
+                push_action(reserve.contract, "issue"_n, converter.account, converter.account, reserve.balance, "setup");
+            }
+
+            push_action(MIGRATION, "addconverter"_n, MIGRATION, converter.relay_symbol.code(), converter.account, TEST_ACCOUNT_1);
+        }
+
+        /// adds the pool of `converter` to an account hosting several pools, its reserves are funded with "setup:<pool>" transfers
+        void add_hosted_pool(const legacy_converter& converter) {
+            const binary_extension<symbol_code> pool(converter.relay_symbol.code());
+            set_contract(converter.account, eosio_mock::legacy_converter_contract());
+            create_pool_token(converter);
+
+            push_action(converter.account, "init"_n, converter.account,
+                converter.relay, asset(0, converter.relay_symbol), true, true, NETWORK, false, uint64_t(30000), converter.fee, pool);
+
+            const string setup = "setup:" + converter.relay_symbol.code().to_string();
+            for (const legacy_reserve& reserve : converter.reserves) {
+                const Token::stats stats_table(reserve.contract, reserve.balance.symbol.code().raw());
+                if (reserve.contract != BNT_TOKEN && stats_table.find(reserve.balance.symbol.code().raw()) == stats_table.end()) { // reserves shared with another pool exist already
+                    set_contract(reserve.contract, eosio_mock::token_contract());
+                    push_action(reserve.contract, "create"_n, reserve.contract, reserve.contract, asset(asset::max_amount / 2, reserve.balance.symbol));
+                }
+                push_action(converter.account, "setreserve"_n, converter.account, reserve.contract, reserve.balance.symbol, reserve.ratio, true, pool);
+                if (reserve.contract == BNT_TOKEN) {
+                    push_action(BNT_TOKEN, "transfer"_n, TEST_ACCOUNT_1, TEST_ACCOUNT_1, converter.account, reserve.balance, setup);
+                    continue;
+                }
+                push_action(reserve.contract, "issue"_n, reserve.contract, reserve.contract, reserve.balance, "");
+                push_action(reserve.contract, "transfer"_n, reserve.contract, reserve.contract, converter.account, reserve.balance, setup);
+            }
+        }
+
+        /// sends a conversion through the network, `path` as in the memo, e.g. "bnt2dddcnvrt DDD"
+        void convert(name from, name token, const asset& quantity, const string& path, const string& min_return = "0.00000001") {
+            push_action(token, "transfer"_n, from, from, NETWORK, quantity, "1," + path + "," + min_return + "," + from.to_string());
+        }
+
+        int64_t balance(name token, name owner, symbol_code sym) const {
+            Token::accounts accounts_table(token, owner.value);
+            auto account = accounts_table.find(sym.raw());
+            return account == accounts_table.end() ? 0 : account->balance.amount;
+        }
+
+        int64_t supply(name token, symbol_code sym) const {
+            return Token::get_supply(token, sym).amount;
+        }
+
+        /// balance of a reserve of a converter in the multi-converter
+        int64_t reserve_balance(symbol_code converter_sym, symbol_code reserve_sym) const {
+            BancorConverter::reserves reserves_table(MULTI_CONVERTER, converter_sym.raw());
+            auto reserve = reserves_table.find(reserve_sym.raw());
+            return reserve == reserves_table.end() ? 0 : reserve->balance.amount;
+        }
+
+        bool has_converter(symbol_code converter_sym) const {
+            BancorConverter::converters converters_table(MULTI_CONVERTER, converter_sym.raw());
+            return converters_table.find(converter_sym.raw()) != converters_table.end();
+        }
+
+        BancorConverter::converter_t new_converter(symbol_code converter_sym) const {
+            BancorConverter::converters converters_table(MULTI_CONVERTER, converter_sym.raw());
+            return converters_table.get(converter_sym.raw(), "converter not found");
+        }
+
+        LegacyBancorConverter::settings_t legacy_settings(name converter) const {
+            LegacyBancorConverter::settings settings_table(converter, converter.value);
+            return settings_table.get("settings"_n.value, "settings do not exist");
+        }
+
+    private:
+        // creates the pool token, issued by the converter, and gives it to the holders
+        void create_pool_token(const legacy_converter& converter) {
+            set_contract(converter.relay, eosio_mock::token_contract());
+
+            const asset max_supply = asset(asset::max_amount / 2, converter.relay_symbol);
+            push_action(converter.relay, "create"_n, converter.relay, converter.account, max_supply);
+            asset supply = asset(0, converter.relay_symbol);
+            for (const auto& [holder, amount] : converter.holders)
+                supply += amount;
+            push_action(converter.relay, "issue"_n, converter.account, converter.account, supply, "");
+            for (const auto& [holder, amount] : converter.holders)
+                push_action(converter.relay, "transfer"_n, converter.account, converter.account, holder, amount, "");
+        }
+};
+
+/// asserts that `transaction` fails with an assertion message containing `message`
+inline void expect_assert(const std::function<void()>& transaction, const string& message) {
+    try {
+        transaction();
+        ADD_FAILURE() << "expected the assertion \"" << message << "\"";
+    }
+    catch (const eosio::eosio_assert_exception& e) {
+        EXPECT_NE(string(e.what()).find(message), string::npos) << "unexpected assertion: " << e.what();
+    }
+}
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <eosio/eosio.hpp>
+
+/**
+ * native test chain, executes transactions against the in-memory state of the mocked eosio headers
+ * actions run the way nodeos runs them: the receiver first, then the accounts it notified,
+ * then the inline actions they sent, depth first, and a failing transaction rolls all of its changes back
+ */
+namespace eosio_mock {
+
+/// applies an action (`receiver == code`) or a notification (`receiver != code`) to a deployed contract
+using apply_handler = std::function<void(eosio::name receiver, eosio::name code, const pending_action& act)>;
+
+/// string literals are sent as `std::string`, every other argument as its decayed type
+template <typename T>
+using action_arg_t = std::conditional_t<std::is_convertible_v<T, const char*>, std::string, std::decay_t<T>>;
+
+template <typename T>
+struct is_binary_extension : std::false_type {};
+
+template <typename T>
+struct is_binary_extension<eosio::binary_extension<T>> : std::true_type {};
+
+/// binds the actions and notification handlers of a contract class, the contract is constructed for every action
+template <typename Contract>
+class dispatcher {
+    using invoker = std::function<void(Contract&, const std::any&)>;
+
+    public:
+        template <typename... Args>
+        dispatcher& action(eosio::name action_name, void (Contract::*method)(Args...)) {
+            _actions[action_name.value] = bind(action_name, method);
+            return *this;
+        }
+
+        template <typename... Args>
+        dispatcher& on_notify(eosio::name action_name, void (Contract::*method)(Args...)) {
+            _notifications[action_name.value] = bind(action_name, method);
+            return *this;
+        }
+
+        void operator()(eosio::name receiver, eosio::name code, const pending_action& act) const {
+            const auto& handlers = receiver == code ? _actions : _notifications;
+            const auto handler = handlers.find(act.name.value);
+            if (handler == handlers.end()) {
+                eosio::check(receiver != code, "unknown action " + act.name.to_string() + " on " + receiver.to_string());
+                return;
+            }
+            Contract contract(receiver, code, eosio::datastream<const char*>(nullptr, 0));
+            handler->second(contract, act.data);
+        }
+
+    private:
+        template <typename... Args>
+        static invoker bind(eosio::name action_name, void (Contract::*method)(Args...)) {
+            return [action_name, method](Contract& contract, const std::any& data) {
+                using args_t = std::tuple<std::decay_t<Args>...>;
+                if (const args_t* args = std::any_cast<args_t>(&data)) {
+                    std::apply([&](const auto&... values) { (contract.*method)(values...); }, *args);
+                    return;
+                }
+                if constexpr (sizeof...(Args) > 0) {
+                    // like the abi serializer, data without a trailing binary extension leaves it empty
+                    using last_t = std::tuple_element_t<sizeof...(Args) - 1, args_t>;
+                    if constexpr (is_binary_extension<last_t>::value) {
+                        using leading_t = decltype(leading(std::declval<args_t>(), std::make_index_sequence<sizeof...(Args) - 1>()));
+                        if (const leading_t* args = std::any_cast<leading_t>(&data)) {
+                            std::apply([&](const auto&... values) { (contract.*method)(values..., last_t()); }, *args);
+                            return;
+                        }
+                    }
+                }
+                eosio::check(false, "action data does not match the parameters of " + action_name.to_string());
+            };
+        }
+
+        template <typename Tuple, size_t... I>
+        static std::tuple<std::tuple_element_t<I, Tuple>...> leading(const Tuple&, std::index_sequence<I...>);
+
+        std::map<uint64_t, invoker> _actions;
+        std::map<uint64_t, invoker> _notifications;
+};
+
+class test_chain {
+    public:
+        /// nodeos' default `max_inline_action_depth`
+        static constexpr uint32_t MAX_INLINE_ACTION_DEPTH = 4;
+
+        test_chain() { chain().reset(); }
+
+        void create_account(eosio::name account) { chain().accounts.insert(account.value); }
+
+        void set_contract(eosio::name account, apply_handler contract) {
+            create_account(account);
+            _contracts[account.value] = std::move(contract);
+        }
+
+        /// pushes a transaction with a single action authorized by `actor`
+        template <typename... Args>
+        void push_action(eosio::name account, eosio::name action_name, eosio::name actor, Args&&... args) {
+            push_transaction(pending_action{
+                account,
+                action_name,
+                { eosio::permission_level(actor, eosio::name("active")) },
+                std::tuple<action_arg_t<Args>...>(std::forward<Args>(args)...)
+            });
+        }
+
+        void push_transaction(const pending_action& act) {
+            auto snapshot = snapshot_tables();
+            chain().console.clear();
+            _executed.clear();
+            _reads.clear();
+            try {
+                execute(act, 0);
+            }
+            catch (...) {
+                chain().tables = std::move(snapshot);
+                throw;
+            }
+        }
+
+        /// output printed by the last transaction
+        const std::string& console() const { return chain().console; }
+
+        /// actions executed by the last transaction, inline actions included, in execution order
+        const std::vector<pending_action>& executed_actions() const { return _executed; }
+
+        /// primitive database reads of `table` by the handlers of `receiver` in the last transaction, notifications included
+        uint64_t db_reads(eosio::name receiver, eosio::name table) const {
+            const auto reads = _reads.find({ receiver.value, table.value });
+            return reads == _reads.end() ? 0 : reads->second;
+        }
+
+        void set_time(uint32_t seconds) { chain().now = seconds; }
+
+    private:
+        void execute(const pending_action& act, uint32_t depth) {
+            eosio::check(depth <= MAX_INLINE_ACTION_DEPTH, "max inline action depth per transaction reached");
+            _executed.push_back(act);
+
+            chain_state& state = chain();
+            std::vector<eosio::name> receivers = { act.account };
+            std::vector<pending_action> inline_actions;
+
+            for (size_t i = 0; i < receivers.size(); i++) {
+                const auto contract = _contracts.find(receivers[i].value);
+                if (contract == _contracts.end()) {
+                    eosio::check(i != 0, "no contract deployed on " + act.account.to_string());
+                    continue;
+                }
+
+                state.auths.clear();
+                for (const eosio::permission_level& permission : act.authorization)
+                    state.auths.insert(permission.actor.value);
+                state.notified.clear();
+                state.inline_actions.clear();
+
+                const std::map<uint64_t, uint64_t> reads_before = state.db_reads;
+                contract->second(receivers[i], act.account, act);
+                for (const auto& [table, reads] : state.db_reads) {
+                    const auto before = reads_before.find(table);
+                    _reads[{ receivers[i].value, table }] += reads - (before == reads_before.end() ? 0 : before->second);
+                }
+
+                for (const eosio::name& notified : state.notified)
+                    if (std::find(receivers.begin(), receivers.end(), notified) == receivers.end())
+                        receivers.push_back(notified);
+                inline_actions.insert(inline_actions.end(), state.inline_actions.begin(), state.inline_actions.end());
+            }
+
+            for (const pending_action& inline_action : inline_actions)
+                execute(inline_action, depth + 1);
+        }
+
+        static std::map<table_id, table_slot> snapshot_tables() {
+            std::map<table_id, table_slot> snapshot;
+            for (const auto& [id, slot] : chain().tables)
+                snapshot[id] = table_slot{ slot.clone(slot.rows), slot.clone };
+            return snapshot;
+        }
+
+        std::map<uint64_t, apply_handler> _contracts;
+        std::vector<pending_action> _executed;
+        std::map<std::pair<uint64_t, uint64_t>, uint64_t> _reads; // by receiver and table
+};
+
+} // namespace eosio_mock
@@ -0,0 +1,253 @@
+/**
+ *  @file
+ *  @copyright defined in ../../../LICENSE
+ */
+
+// native implementation of the multi-converter declared in src/includes/BancorConverter.hpp,
+// limited to the converter management and liquidity actions the migration depends on (no conversions)
+
+#include "../../../src/includes/BancorConverter.hpp"
+#include "../../../src/includes/Token.hpp"
+
+ACTION BancorConverter::setmultitokn(name multi_token) {
+    require_auth(get_self());
+
+    settings settings_table(get_self(), get_self().value);
+    check(settings_table.find("settings"_n.value) == settings_table.end(), "can only call setmultitokn once");
+    settings_table.emplace(get_self(), [&](auto& s) {
+        s.max_fee = 0;
+        s.multi_token = multi_token;
+    });
+}
+
+ACTION BancorConverter::setmaxfee(uint64_t maxfee) {
+    require_auth(get_self());
+    check(maxfee <= MAX_FEE, "maximum fee must be lower or equal to the MAX_FEE");
+
+    settings settings_table(get_self(), get_self().value);
+    const auto& st = settings_table.get("settings"_n.value, "settings do not exist");
+    settings_table.modify(st, same_payer, [&](auto& s) {
+        s.max_fee = maxfee;
+    });
+}
+
+ACTION BancorConverter::setnetwork(name network) {
+    require_auth(get_self());
+    check(is_account(network), "network account doesn't exist");
+
+    settings settings_table(get_self(), get_self().value);
+    const auto& st = settings_table.get("settings"_n.value, "settings do not exist");
+    settings_table.modify(st, same_payer, [&](auto& s) {
+        s.network = network;
+    });
+}
+
+// the multi-token contract is expected to let the multi-converter create tokens on its behalf
+ACTION BancorConverter::create(name owner, symbol_code token_code, double initial_supply) {
+    require_auth(owner);
+    check(token_code.is_valid(), "token_code is invalid");
+
+    settings settings_table(get_self(), get_self().value);
+    const auto& st = settings_table.get("settings"_n.value, "must first initialize multi-token");
+
+    const symbol token_symbol = symbol(token_code, DEFAULT_TOKEN_PRECISION);
+    const asset initial = asset(tokens_to_amount(initial_supply, DEFAULT_TOKEN_PRECISION), token_symbol);
+    const asset maximum = asset(tokens_to_amount(DEFAULT_MAX_SUPPLY, DEFAULT_TOKEN_PRECISION), token_symbol);
+    check(initial.amount > 0, "initial supply must be positive");
+
+    converters converters_table(get_self(), token_code.raw());
+    check(converters_table.find(token_code.raw()) == converters_table.end(), "converter for the given symbol already exists");
+    converters_table.emplace(owner, [&](auto& c) {
+        c.currency = token_symbol;
+        c.owner = owner;
+        c.stake_enabled = false;
+        c.fee = 0;
+    });
+
+    action(permission_level{ st.multi_token, "active"_n }, st.multi_token, "create"_n,
+        make_tuple(get_self(), maximum)
+    ).send();
+    action(permission_level{ get_self(), "active"_n }, st.multi_token, "issue"_n,
+        make_tuple(get_self(), initial, string("setup"))
+    ).send();
+    action(permission_level{ get_self(), "active"_n }, st.multi_token, "transfer"_n,
+        make_tuple(get_self(), owner, initial, string("setup"))
+    ).send();
+}
+
+ACTION BancorConverter::updateowner(symbol_code currency, name new_owner) {
+    converters converters_table(get_self(), currency.raw());
+    const auto& converter = converters_table.get(currency.raw(), "converter does not exist");
+    require_auth(converter.owner);
+    check(is_account(new_owner), "new owner is not an account");
+
+    converters_table.modify(converter, same_payer, [&](auto& c) {
+        c.owner = new_owner;
+    });
+}
+
+ACTION BancorConverter::updatefee(symbol_code currency, uint64_t fee) {
+    settings settings_table(get_self(), get_self().value);
+    const auto& st = settings_table.get("settings"_n.value, "settings do not exist");
+
+    converters converters_table(get_self(), currency.raw());
+    const auto& converter = converters_table.get(currency.raw(), "converter does not exist");
+    require_auth(converter.owner);
+    check(fee <= st.max_fee, "fee must be lower or equal to the maximum fee");
+
+    converters_table.modify(converter, same_payer, [&](auto& c) {
+        c.fee = fee;
+    });
+}
+
+ACTION BancorConverter::setreserve(symbol_code converter_currency_code, symbol currency, name contract, uint64_t ratio) {
+    converters converters_table(get_self(), converter_currency_code.raw());
+    const auto& converter = converters_table.get(converter_currency_code.raw(), "converter does not exist");
+    require_auth(converter.owner);
+    check(currency.is_valid(), "invalid reserve symbol");
+    check(is_account(contract), "token's contract is not an account");
+    check(ratio > 0 && ratio <= MAX_RATIO, "ratio must be between 1 and 1000000");
+
+    reserves reserves_table(get_self(), converter_currency_code.raw());
+    auto existing = reserves_table.find(currency.code().raw());
+    if (existing != reserves_table.end()) {
+        check(existing->contract == contract, "cannot update the reserve contract name");
+        reserves_table.modify(existing, same_payer, [&](auto& r) {
+            r.ratio = ratio;
+        });
+    }
+    else reserves_table.emplace(get_self(), [&](auto& r) {
+        r.contract = contract;
+        r.ratio = ratio;
+        r.balance = asset(0, currency);
+    });
+
+    uint64_t total_ratio = 0;
+    for (const auto& reserve : reserves_table)
+        total_ratio += reserve.ratio;
+    check(total_ratio <= MAX_RATIO, "total ratio cannot exceed the maximum ratio");
+}
+
+ACTION BancorConverter::withdraw(name sender, asset quantity, symbol_code converter_currency_code) {
+    require_auth(sender);
+    check(quantity.is_valid() && quantity.amount > 0, "invalid quantity");
+
+    mod_account_balance(sender, converter_currency_code, -quantity);
+
+    const reserve_t& reserve = get_reserve(quantity.symbol.code(), converter_currency_code);
+    action(permission_level{ get_self(), "active"_n }, reserve.contract, "transfer"_n,
+        make_tuple(get_self(), sender, quantity, string("withdrawal"))
+    ).send();
+}
+
+ACTION BancorConverter::fund(name sender, asset quantity) {
+    require_auth(sender);
+    check(quantity.is_valid() && quantity.amount > 0, "invalid quantity");
+
+    settings settings_table(get_self(), get_self().value);
+    const auto& st = settings_table.get("settings"_n.value, "settings do not exist");
+
+    const symbol_code converter_currency_code = quantity.symbol.code();
+    converters converters_table(get_self(), converter_currency_code.raw());
+    const auto& converter = converters_table.get(converter_currency_code.raw(), "converter does not exist");
+    check(converter.currency == quantity.symbol, "symbol mismatch");
+
+    const int64_t supply = get_supply(st.multi_token, converter_currency_code).amount;
+    reserves reserves_table(get_self(), converter_currency_code.raw());
+    for (const reserve_t& reserve : reserves_table) {
+        const asset cost = asset(mul_div(reserve.balance.amount, quantity.amount, supply, rounding_mode::up), reserve.balance.symbol);
+        check(cost.amount > 0, "fund amount too small");
+        mod_account_balance(sender, converter_currency_code, -cost);
+        mod_reserve_balance(converter.currency, cost);
+    }
+
+    action(permission_level{ get_self(), "active"_n }, st.multi_token, "issue"_n,
+        make_tuple(get_self(), quantity, string("fund"))
+    ).send();
+    action(permission_level{ get_self(), "active"_n }, st.multi_token, "transfer"_n,
+        make_tuple(get_self(), sender, quantity, string("fund"))
+    ).send();
+}
+
+// deposits sent with a "fund;<converter currency>" memo
+void BancorConverter::on_transfer(name from, name to, asset quantity, string memo) {
+    if (from == get_self() || to != get_self())
+        return;
+    require_auth(from);
+
+    const size_t separator = memo.find(';');
+    check(separator != string::npos && memo.substr(0, separator) == "fund", "only fund deposits are supported");
+    const symbol_code converter_currency_code = symbol_code(memo.substr(separator + 1));
+
+    mod_balances(from, quantity, converter_currency_code, get_first_receiver());
+}
+
+// the owner's deposits fund the reserves directly until every reserve holds a balance
+void BancorConverter::mod_balances(name sender, asset quantity, symbol_code converter_currency_code, name code) {
+    converters converters_table(get_self(), converter_currency_code.raw());
+    const auto& converter = converters_table.get(converter_currency_code.raw(), "converter does not exist");
+
+    const reserve_t& reserve = get_reserve(quantity.symbol.code(), converter_currency_code);
+    check(reserve.contract == code, "wrong origin contract for quantity");
+
+    if (converter.owner == sender && !is_converter_active(converter_currency_code))
+        mod_reserve_balance(converter.currency, quantity);
+    else
+        mod_account_balance(sender, converter_currency_code, quantity);
+}
+
+void BancorConverter::mod_account_balance(name sender, symbol_code converter_currency_code, asset quantity) {
+    accounts accounts_table(get_self(), sender.value);
+    const auto index = accounts_table.get_index<"bycnvrt"_n >();
+    const auto existing = index.find(_by_cnvrt(quantity, converter_currency_code));
+
+    if (existing == index.end()) {
+        check(quantity.amount > 0, "cannot withdraw non-existant deposit");
+        accounts_table.emplace(get_self(), [&](auto& a) {
+            a.id = accounts_table.available_primary_key();
+            a.symbl = converter_currency_code;
+            a.quantity = quantity;
+        });
+        return;
+    }
+
+    const asset balance = existing->quantity + quantity;
+    check(balance.amount >= 0, "insufficient balance");
+    if (balance.amount == 0)
+        accounts_table.erase(*existing);
+    else
+        accounts_table.modify(*existing, same_payer, [&](auto& a) {
+            a.quantity = balance;
+        });
+}
+
+void BancorConverter::mod_reserve_balance(symbol converter_currency, asset value, int64_t pending_supply_change) {
+    reserves reserves_table(get_self(), converter_currency.code().raw());
+    const auto& reserve = reserves_table.get(value.symbol.code().raw(), "reserve not found");
+
+    reserves_table.modify(reserve, same_payer, [&](auto& r) {
+        r.balance += value;
+        check(r.balance.amount >= 0, "insufficient amount in reserve");
+    });
+}
+
+const BancorConverter::reserve_t& BancorConverter::get_reserve(symbol_code symbl, symbol_code converter_currency) {
+    reserves reserves_table(get_self(), converter_currency.raw());
+    return reserves_table.get(symbl.raw(), "reserve not found");
+}
+
+bool BancorConverter::is_converter_active(symbol_code converter) {
+    reserves reserves_table(get_self(), converter.raw());
+    if (reserves_table.begin() == reserves_table.end())
+        return false;
+
+    for (const reserve_t& reserve : reserves_table)
+        if (reserve.balance.amount == 0)
+            return false;
+
+    return true;
+}
+
+asset BancorConverter::get_supply(name contract, symbol_code sym) {
+    return Token::get_supply(contract, sym);
+}
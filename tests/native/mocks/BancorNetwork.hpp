@@ -0,0 +1,52 @@
+/**
+ *  @file
+ *  @copyright defined in ../../../LICENSE
+ */
+#pragma once
+
+#include <eosio/eosio.hpp>
+
+#include "../../../src/includes/Common/common.hpp"
+
+/**
+ * native stand-in for the bancor network contract, routes conversions along their path:
+ * a transfer whose memo still has a path is forwarded to the path's first converter,
+ * a transfer with an exhausted path is sent to the destination account,
+ * a transfer with a "batch" (or "batch:<pool>") memo is held for a batch conversion that the test submits on the network's behalf,
+ * routes referenced by version 2 memos are registered with `addroute`
+ */
+CONTRACT BancorNetwork : public contract {
+    public:
+        using contract::contract;
+
+        typedef eosio::multi_index<"routes"_n, route_t> routes;
+
+        void addroute(uint64_t id, const ::path& path) {
+            require_auth(get_self());
+            check(id != 0 && !path.empty() && path.size() % 2 == 0, "invalid route");
+            routes routes_table(get_self(), get_self().value);
+            routes_table.emplace(get_self(), [&](auto& r) {
+                r.id = id;
+                r.path = path;
+            });
+        }
+
+        void on_transfer(name from, name to, asset quantity, string memo) {
+            if (from == get_self() || to != get_self() || memo.rfind("batch", 0) == 0)
+                return;
+
+            memo_structure memo_object = parse_memo(memo);
+            if (memo_object.route_id) {
+                routes routes_table(get_self(), get_self().value);
+                resolve_route(memo_object, routes_table.get(memo_object.route_id, "route not found"));
+            }
+            const bool path_done = memo_object.path.empty();
+            const name receiver = path_done ? name(memo_object.dest_account) : memo_object.converters[0].account;
+
+            action(
+                permission_level{ get_self(), "active"_n },
+                get_first_receiver(), "transfer"_n,
+                make_tuple(get_self(), receiver, quantity, path_done ? memo_object.receiver_memo : memo)
+            ).send();
+        }
+};
@@ -0,0 +1,141 @@
+/**
+ *  @file
+ *  @copyright defined in ../../../LICENSE
+ */
+
+// native implementation of the token contract declared in src/includes/Token.hpp, following eosio.token
+
+#include "../../../src/includes/Token.hpp"
+
+ACTION Token::create(name issuer, asset maximum_supply) {
+    require_auth(get_self());
+
+    const symbol sym = maximum_supply.symbol;
+    check(sym.is_valid(), "invalid symbol name");
+    check(maximum_supply.is_valid(), "invalid supply");
+    check(maximum_supply.amount > 0, "max-supply must be positive");
+
+    stats statstable(get_self(), sym.code().raw());
+    check(statstable.find(sym.code().raw()) == statstable.end(), "token with symbol already exists");
+
+    statstable.emplace(get_self(), [&](auto& s) {
+        s.supply.symbol = maximum_supply.symbol;
+        s.max_supply    = maximum_supply;
+        s.issuer        = issuer;
+    });
+}
+
+ACTION Token::issue(name to, asset quantity, string memo) {
+    const symbol sym = quantity.symbol;
+    check(sym.is_valid(), "invalid symbol name");
+    check(memo.size() <= 256, "memo has more than 256 bytes");
+
+    stats statstable(get_self(), sym.code().raw());
+    const auto& st = statstable.get(sym.code().raw(), "token with symbol does not exist, create token before issue");
+    check(to == st.issuer, "tokens can only be issued to issuer account");
+
+    require_auth(st.issuer);
+    check(quantity.is_valid(), "invalid quantity");
+    check(quantity.amount > 0, "must issue positive quantity");
+    check(quantity.symbol == st.supply.symbol, "symbol precision mismatch");
+    check(quantity.amount <= st.max_supply.amount - st.supply.amount, "quantity exceeds available supply");
+
+    statstable.modify(st, same_payer, [&](auto& s) {
+        s.supply += quantity;
+    });
+
+    add_balance(st.issuer, quantity, st.issuer);
+}
+
+ACTION Token::retire(asset quantity, string memo) {
+    const symbol sym = quantity.symbol;
+    check(sym.is_valid(), "invalid symbol name");
+    check(memo.size() <= 256, "memo has more than 256 bytes");
+
+    stats statstable(get_self(), sym.code().raw());
+    const auto& st = statstable.get(sym.code().raw(), "token with symbol does not exist");
+
+    require_auth(st.issuer);
+    check(quantity.is_valid(), "invalid quantity");
+    check(quantity.amount > 0, "must retire positive quantity");
+    check(quantity.symbol == st.supply.symbol, "symbol precision mismatch");
+
+    statstable.modify(st, same_payer, [&](auto& s) {
+        s.supply -= quantity;
+    });
+
+    sub_balance(st.issuer, quantity);
+}
+
+ACTION Token::transfer(name from, name to, asset quantity, string memo) {
+    check(from != to, "cannot transfer to self");
+    require_auth(from);
+    check(is_account(to), "to account does not exist");
+
+    const auto sym = quantity.symbol.code();
+    stats statstable(get_self(), sym.raw());
+    const auto& st = statstable.get(sym.raw(), "token with symbol does not exist");
+
+    require_recipient(from);
+    require_recipient(to);
+
+    check(quantity.is_valid(), "invalid quantity");
+    check(quantity.amount > 0, "must transfer positive quantity");
+    check(quantity.symbol == st.supply.symbol, "symbol precision mismatch");
+    check(memo.size() <= 256, "memo has more than 256 bytes");
+
+    sub_balance(from, quantity);
+    add_balance(to, quantity, from);
+}
+
+ACTION Token::transferbyid(name from, name to, name amount_account, uint64_t amount_id, string memo) {
+    check(false, "transferbyid is not supported by the native token");
+}
+
+ACTION Token::open(name owner, symbol_code symbol, name ram_payer) {
+    require_auth(ram_payer);
+    check(is_account(owner), "owner account does not exist");
+
+    stats statstable(get_self(), symbol.raw());
+    const auto& st = statstable.get(symbol.raw(), "symbol does not exist");
+
+    accounts acnts(get_self(), owner.value);
+    if (acnts.find(symbol.raw()) == acnts.end())
+        acnts.emplace(ram_payer, [&](auto& a) {
+            a.balance = asset(0, st.supply.symbol);
+        });
+}
+
+ACTION Token::close(name owner, symbol_code symbol) {
+    require_auth(owner);
+
+    accounts acnts(get_self(), owner.value);
+    auto it = acnts.find(symbol.raw());
+    check(it != acnts.end(), "Balance row already deleted or never existed. Action won't have any effect.");
+    check(it->balance.amount == 0, "Cannot close because the balance is not zero.");
+    acnts.erase(it);
+}
+
+void Token::sub_balance(name owner, asset value) {
+    accounts from_acnts(get_self(), owner.value);
+
+    const auto& from = from_acnts.get(value.symbol.code().raw(), "no balance object found");
+    check(from.balance.amount >= value.amount, "overdrawn balance");
+
+    from_acnts.modify(from, owner, [&](auto& a) {
+        a.balance -= value;
+    });
+}
+
+void Token::add_balance(name owner, asset value, name ram_payer) {
+    accounts to_acnts(get_self(), owner.value);
+    auto to = to_acnts.find(value.symbol.code().raw());
+    if (to == to_acnts.end())
+        to_acnts.emplace(ram_payer, [&](auto& a) {
+            a.balance = value;
+        });
+    else
+        to_acnts.modify(to, same_payer, [&](auto& a) {
+            a.balance += value;
+        });
+}
@@ -0,0 +1,123 @@
+/**
+ * compares the event decoder with a generic JSON parser (jsoncpp) on a synthetic console log
+ *
+ * usage: event_decoder_bench [events]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include <json/json.h>
+
+#include "event_decoder.hpp"
+
+using namespace events;
+
+// the layout printed by EVENTKV / EVENTKVL, doubles as printdf prints them
+static std::string synthetic_console(size_t count) {
+    std::mt19937_64 random(20201019);
+    std::uniform_real_distribution<double> amount(0.0001, 100000);
+    std::string console;
+    char buf[1024];
+    for (size_t i = 0; i < count; i++) {
+        switch (random() % 4) {
+            case 0:
+                snprintf(buf, sizeof(buf), "{\"version\":\"1.3\",\"etype\":\"conversion\",\"memo\":\"1,bnt2dddcnvrt DDD,0.00000001,bnttestuser1;\","
+                    "\"from_contract\":\"bntbntbntbnt\",\"from_symbol\":\"BNT\",\"to_contract\":\"ddd\",\"to_symbol\":\"DDD\","
+                    "\"amount\":\"%.17e\",\"return\":\"%.17e\",\"conversion_fee\":\"%.17e\"}\n", amount(random), amount(random), amount(random));
+                break;
+            case 1:
+                snprintf(buf, sizeof(buf), "{\"version\":\"1.4\",\"etype\":\"price_data\",\"smart_supply\":\"%.17e\",\"reserve_contract\":\"ddd\","
+                    "\"reserve_symbol\":\"DDD\",\"reserve_balance\":\"%.17e\",\"reserve_ratio\":\"%.17e\"}\n", amount(random), amount(random), 0.5);
+                break;
+            case 2:
+                snprintf(buf, sizeof(buf), "{\"version\":\"1.0\",\"etype\":\"pool_state\",\"smart_supply\":\"%.17e\",\"reserves\":["
+                    "{\"contract\":\"bntbntbntbnt\",\"symbol\":\"BNT\",\"balance\":\"%.17e\",\"ratio\":\"%.17e\"},"
+                    "{\"contract\":\"ddd\",\"symbol\":\"DDD\",\"balance\":\"%.17e\",\"ratio\":\"%.17e\"}]}\n", amount(random), amount(random), 0.5, amount(random), 0.5);
+                break;
+            default:
+                snprintf(buf, sizeof(buf), "{\"version\":\"1.1\",\"etype\":\"conversion_fee_update\",\"prev_fee\":\"%llu\",\"new_fee\":\"%llu\"}\n",
+                    (unsigned long long)(random() % 30000), (unsigned long long)(random() % 30000));
+        }
+        console += buf;
+    }
+    return console;
+}
+
+struct checksum {
+    size_t events = 0;
+    double total = 0;
+
+    void operator()(const conversion_event& e) { events++; total += e.amount + e.return_amount + e.conversion_fee + e.memo.size(); }
+    void operator()(const price_data_event& e) { events++; total += e.smart_supply + e.reserve_balance + e.reserve_ratio; }
+    void operator()(const pool_state_event& e) {
+        events++;
+        total += e.smart_supply;
+        for (size_t i = 0; i < e.reserves_count; i++)
+            total += e.reserves[i].balance + e.reserves[i].ratio;
+    }
+    void operator()(const conversion_fee_update_event& e) { events++; total += e.prev_fee + e.new_fee; }
+};
+
+// what an indexer does with a generic parser: parse every line into a DOM, then read the typed fields out of it
+static checksum decode_with_jsoncpp(const std::string& console) {
+    checksum sum;
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    Json::Value root;
+    std::string errors;
+
+    size_t start = 0;
+    while (start < console.size()) {
+        const size_t end = console.find('\n', start);
+        if (!reader->parse(console.data() + start, console.data() + end, &root, &errors))
+            break;
+        start = end + 1;
+
+        const std::string etype = root["etype"].asString();
+        if (etype == "conversion")
+            sum({ {}, root["memo"].asString(), {}, {}, {}, {}, std::stod(root["amount"].asString()),
+                std::stod(root["return"].asString()), std::stod(root["conversion_fee"].asString()) });
+        else if (etype == "price_data")
+            sum({ {}, std::stod(root["smart_supply"].asString()), {}, {},
+                std::stod(root["reserve_balance"].asString()), std::stod(root["reserve_ratio"].asString()) });
+        else if (etype == "pool_state") {
+            std::vector<reserve_state> reserves;
+            for (const Json::Value& reserve : root["reserves"])
+                reserves.push_back({ {}, {}, std::stod(reserve["balance"].asString()), std::stod(reserve["ratio"].asString()) });
+            sum({ {}, std::stod(root["smart_supply"].asString()), reserves.data(), reserves.size() });
+        }
+        else if (etype == "conversion_fee_update")
+            sum({ {}, std::stoull(root["prev_fee"].asString()), std::stoull(root["new_fee"].asString()) });
+    }
+    return sum;
+}
+
+template <typename F>
+static double measure(F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    const size_t count = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    const std::string console = synthetic_console(count);
+    const double megabytes = console.size() / 1e6;
+
+    checksum decoded;
+    event_decoder decoder;
+    const double decoder_seconds = measure([&] { decoder.decode(console, decoded); });
+
+    checksum parsed;
+    const double jsoncpp_seconds = measure([&] { parsed = decode_with_jsoncpp(console); });
+
+    printf("%zu events, %.1f MB\n", count, megabytes);
+    printf("event_decoder: %8.3f s %10.1f MB/s %12.0f events/s\n", decoder_seconds, megabytes / decoder_seconds, decoded.events / decoder_seconds);
+    printf("jsoncpp:       %8.3f s %10.1f MB/s %12.0f events/s\n", jsoncpp_seconds, megabytes / jsoncpp_seconds, parsed.events / jsoncpp_seconds);
+    printf("speedup: %.1fx, checksums %s\n", jsoncpp_seconds / decoder_seconds,
+        decoded.events == parsed.events && decoded.total == parsed.total ? "match" : "differ");
+    return decoded.events == parsed.events ? 0 : 1;
+}
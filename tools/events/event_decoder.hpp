@@ -0,0 +1,220 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief decoder for the events that the converter prints to the console (src/includes/Common/events.hpp)
+ * @details the events are not parsed as generic JSON: every event type has a fixed key order and every value is quoted,
+ * so the decoder matches the expected keys as literals and slices the values out of the console output without copying,
+ * the string fields of a decoded event point into the decoded buffer and are only valid as long as it is
+ */
+namespace events {
+
+/// triggered when a conversion between two tokens occurs
+struct conversion_event {
+    std::string_view version;
+    std::string_view memo;
+    std::string_view from_contract;
+    std::string_view from_symbol;
+    std::string_view to_contract;
+    std::string_view to_symbol;
+    double amount;
+    double return_amount;
+    double conversion_fee;
+};
+
+/// triggered after a conversion with new tokens price data
+struct price_data_event {
+    std::string_view version;
+    double smart_supply;
+    std::string_view reserve_contract;
+    std::string_view reserve_symbol;
+    double reserve_balance;
+    double reserve_ratio;
+};
+
+struct reserve_state {
+    std::string_view contract;
+    std::string_view symbol;
+    double balance;
+    double ratio;
+};
+
+/// triggered after a conversion with the state of all the reserves, `reserves` is only valid during the handler call
+struct pool_state_event {
+    std::string_view version;
+    double smart_supply;
+    const reserve_state* reserves;
+    size_t reserves_count;
+};
+
+/// triggered when the conversion fee is updated
+struct conversion_fee_update_event {
+    std::string_view version;
+    uint64_t prev_fee;
+    uint64_t new_fee;
+};
+
+struct decode_stats {
+    size_t events = 0;
+    size_t malformed = 0; // events of a known type that did not match their layout, unknown event types are skipped silently
+};
+
+class event_decoder {
+    public:
+        /**
+         * @brief decodes every event in `console` and calls `handler` with each of them, in order
+         * @details `handler` is called with a `const conversion_event&`, `const price_data_event&`, `const pool_state_event&`
+         * or `const conversion_fee_update_event&`, e.g. an overloaded set of lambdas, text between events is ignored
+         */
+        template <typename Handler>
+        decode_stats decode(std::string_view console, Handler&& handler) {
+            decode_stats stats;
+            size_t start = console.find(EVENT_START);
+            while (start != std::string_view::npos) {
+                cursor c = { console.data() + start + EVENT_START.size(), console.data() + console.size() };
+                const outcome result = decode_event(c, handler);
+                if (result == outcome::decoded)
+                    stats.events++;
+                else if (result == outcome::malformed)
+                    stats.malformed++;
+
+                const size_t next = result == outcome::decoded ? c.pos - console.data() : start + 1;
+                start = console.find(EVENT_START, next);
+            }
+            return stats;
+        }
+
+    private:
+        static constexpr std::string_view EVENT_START = "{\"version\":\"";
+
+        enum class outcome { decoded, malformed, unknown };
+
+        struct cursor {
+            const char* pos;
+            const char* end;
+
+            bool literal(std::string_view expected) {
+                if (size_t(end - pos) < expected.size() || memcmp(pos, expected.data(), expected.size()) != 0)
+                    return false;
+                pos += expected.size();
+                return true;
+            }
+
+            // a value that cannot contain a quote, e.g. a name, a symbol or a number
+            bool quoted(std::string_view& value) {
+                const char* quote = static_cast<const char*>(memchr(pos, '"', end - pos));
+                if (!quote)
+                    return false;
+                value = std::string_view(pos, quote - pos);
+                pos = quote + 1;
+                return true;
+            }
+
+            // a value printed as is, e.g. a memo, that ends right before `terminator`
+            bool until(std::string_view terminator, std::string_view& value) {
+                const size_t found = std::string_view(pos, end - pos).find(terminator);
+                if (found == std::string_view::npos)
+                    return false;
+                value = std::string_view(pos, found);
+                pos += found + terminator.size();
+                return true;
+            }
+
+            bool field(std::string_view key, std::string_view& value) {
+                return literal("\"") && literal(key) && literal("\":\"") && quoted(value);
+            }
+
+            bool field(std::string_view key, double& value) {
+                std::string_view text;
+                return field(key, text) && parse(text, value);
+            }
+
+            bool field(std::string_view key, uint64_t& value) {
+                std::string_view text;
+                return field(key, text) && parse(text, value);
+            }
+
+            template <typename T>
+            static bool parse(std::string_view text, T& value) {
+                const auto [ptr, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+                return error == std::errc() && ptr == text.data() + text.size();
+            }
+        };
+
+        template <typename Handler>
+        outcome decode_event(cursor& c, Handler& handler) {
+            std::string_view version, etype;
+            if (!c.quoted(version) || !c.literal(",") || !c.field("etype", etype) || !c.literal(","))
+                return outcome::malformed;
+
+            if (etype == "conversion") {
+                conversion_event e;
+                e.version = version;
+                if (!c.literal("\"memo\":\"") || !c.until("\",\"from_contract\":\"", e.memo) ||
+                    !c.quoted(e.from_contract) || !c.literal(",") ||
+                    !c.field("from_symbol", e.from_symbol) || !c.literal(",") ||
+                    !c.field("to_contract", e.to_contract) || !c.literal(",") ||
+                    !c.field("to_symbol", e.to_symbol) || !c.literal(",") ||
+                    !c.field("amount", e.amount) || !c.literal(",") ||
+                    !c.field("return", e.return_amount) || !c.literal(",") ||
+                    !c.field("conversion_fee", e.conversion_fee) || !c.literal("}\n"))
+                    return outcome::malformed;
+                handler(static_cast<const conversion_event&>(e));
+            }
+            else if (etype == "price_data") {
+                price_data_event e;
+                e.version = version;
+                if (!c.field("smart_supply", e.smart_supply) || !c.literal(",") ||
+                    !c.field("reserve_contract", e.reserve_contract) || !c.literal(",") ||
+                    !c.field("reserve_symbol", e.reserve_symbol) || !c.literal(",") ||
+                    !c.field("reserve_balance", e.reserve_balance) || !c.literal(",") ||
+                    !c.field("reserve_ratio", e.reserve_ratio) || !c.literal("}\n"))
+                    return outcome::malformed;
+                handler(static_cast<const price_data_event&>(e));
+            }
+            else if (etype == "pool_state") {
+                pool_state_event e;
+                e.version = version;
+                if (!c.field("smart_supply", e.smart_supply) || !c.literal(",\"reserves\":["))
+                    return outcome::malformed;
+
+                reserves.clear();
+                while (!c.literal("]")) {
+                    reserve_state reserve;
+                    if ((!reserves.empty() && !c.literal(",")) || !c.literal("{") ||
+                        !c.field("contract", reserve.contract) || !c.literal(",") ||
+                        !c.field("symbol", reserve.symbol) || !c.literal(",") ||
+                        !c.field("balance", reserve.balance) || !c.literal(",") ||
+                        !c.field("ratio", reserve.ratio) || !c.literal("}"))
+                        return outcome::malformed;
+                    reserves.push_back(reserve);
+                }
+                if (!c.literal("}\n"))
+                    return outcome::malformed;
+
+                e.reserves = reserves.data();
+                e.reserves_count = reserves.size();
+                handler(static_cast<const pool_state_event&>(e));
+            }
+            else if (etype == "conversion_fee_update") {
+                conversion_fee_update_event e;
+                e.version = version;
+                if (!c.field("prev_fee", e.prev_fee) || !c.literal(",") ||
+                    !c.field("new_fee", e.new_fee) || !c.literal("}\n"))
+                    return outcome::malformed;
+                handler(static_cast<const conversion_fee_update_event&>(e));
+            }
+            else return outcome::unknown;
+
+            return outcome::decoded;
+        }
+
+        std::vector<reserve_state> reserves; // reused by every pool state event
+};
+
+} // namespace events
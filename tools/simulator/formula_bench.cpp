@@ -0,0 +1,78 @@
+/**
+ * compares the direct cross reserve formula with the two step (purchase then sale) path on random reserve to reserve conversions
+ *
+ * usage: formula_bench [conversions]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../../src/lib/bancor_formula.hpp"
+
+struct conversion {
+    double from_balance;
+    double amount;
+    double to_balance;
+    double supply;
+    curve_coefficients from_curve;
+    curve_coefficients to_curve;
+};
+
+static std::vector<conversion> random_conversions(size_t count) {
+    std::mt19937_64 random(20201019);
+    std::uniform_real_distribution<double> unit(0, 1);
+    const uint64_t ratios[] = { 100000, 200000, 250000, 300000, 400000, 600000, 750000, 900000 };
+    std::vector<conversion> conversions;
+    conversions.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        const size_t from_index = random() % 8;
+        const uint64_t from_ratio = ratios[from_index];
+        const uint64_t to_ratio = ratios[(from_index + 1 + random() % 7) % 8]; // equal ratios go through quick_convert
+
+        const double from_balance = 1 + unit(random) * 1e9;
+        conversions.push_back({ from_balance, from_balance * unit(random) * 0.05, 1 + unit(random) * 1e9, 1 + unit(random) * 1e9,
+            make_curve_coefficients(from_ratio), make_curve_coefficients(to_ratio) });
+    }
+    return conversions;
+}
+
+template <typename F>
+static double measure(F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    const size_t count = argc > 1 ? std::stoull(argv[1]) : 10000000;
+    const std::vector<conversion> conversions = random_conversions(count);
+    std::vector<double> direct(count), two_step(count);
+
+    const double direct_seconds = measure([&] {
+        for (size_t i = 0; i < count; i++) {
+            const conversion& c = conversions[i];
+            direct[i] = calculate_cross_reserve_return(c.from_balance, c.amount, c.to_balance, c.from_curve, c.to_curve);
+        }
+    });
+    const double two_step_seconds = measure([&] {
+        for (size_t i = 0; i < count; i++) {
+            const conversion& c = conversions[i];
+            const double smart_tokens = calculate_purchase_return(c.from_balance, c.amount, c.supply, c.from_curve);
+            two_step[i] = calculate_sale_return(c.to_balance, smart_tokens, c.supply + smart_tokens, c.to_curve);
+        }
+    });
+
+    double max_error = 0;
+    for (size_t i = 0; i < count; i++)
+        max_error = std::max(max_error, std::abs(direct[i] - two_step[i]) / conversions[i].to_balance);
+
+    printf("%zu conversions\n", count);
+    printf("direct:   %8.3f s %8.1f ns/conversion\n", direct_seconds, direct_seconds * 1e9 / count);
+    printf("two step: %8.3f s %8.1f ns/conversion\n", two_step_seconds, two_step_seconds * 1e9 / count);
+    printf("speedup: %.2fx, max difference %.3e of the 'to' balance\n", two_step_seconds / direct_seconds, max_error);
+    return 0;
+}
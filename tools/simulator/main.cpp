@@ -0,0 +1,113 @@
+/**
+ * simulates random trades on random legacy converter pools and reports the reserve trajectories and the fee revenue
+ *
+ * usage: pool_simulator [--pools N] [--trades N] [--threads N] [--seed N] [--sample N] [--max-share X] [--output FILE]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+
+#include "pool_simulator.hpp"
+
+using namespace simulator;
+
+struct options {
+    size_t pools = 1000;
+    size_t trades = 10000;
+    size_t threads = std::thread::hardware_concurrency();
+    uint64_t seed = 20201019;
+    size_t sample = 100;
+    double max_share = 0.01;
+    std::string output;
+};
+
+static bool parse_options(int argc, char** argv, options& opts) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string key = argv[i];
+        const char* value = argv[i + 1];
+        if (key == "--pools") opts.pools = std::stoull(value);
+        else if (key == "--trades") opts.trades = std::stoull(value);
+        else if (key == "--threads") opts.threads = std::stoull(value);
+        else if (key == "--seed") opts.seed = std::stoull(value);
+        else if (key == "--sample") opts.sample = std::stoull(value);
+        else if (key == "--max-share") opts.max_share = std::stod(value);
+        else if (key == "--output") opts.output = value;
+        else return false;
+    }
+    return argc % 2 == 1 && opts.sample > 0;
+}
+
+// pools shaped like the converters of scripts/deploy.sh: a BNT reserve, one or two more reserves and a fee up to 3%
+static pool_book random_pools(size_t count, uint64_t seed) {
+    std::mt19937_64 random(seed);
+    std::uniform_int_distribution<int64_t> amount(10000000000, 100000000000000);
+
+    pool_book book;
+    for (size_t p = 0; p < count; p++) {
+        const size_t reserves_count = 2 + random() % 2;
+        std::vector<reserve_params> reserves;
+        uint64_t remaining_ratio = 1000000;
+        for (size_t i = 0; i < reserves_count; i++) {
+            const uint64_t ratio = i + 1 == reserves_count ? remaining_ratio : 100000 + random() % (remaining_ratio - 100000 * (reserves_count - i));
+            remaining_ratio -= ratio;
+            reserves.push_back({ amount(random), uint8_t(i == 0 ? 8 : 4 + random() % 5), ratio });
+        }
+        book.add_pool(amount(random), 8, random() % 30001, reserves);
+    }
+    return book;
+}
+
+int main(int argc, char** argv) {
+    options opts;
+    if (!parse_options(argc, argv, opts)) {
+        fprintf(stderr, "usage: %s [--pools N] [--trades N] [--threads N] [--seed N] [--sample N] [--max-share X] [--output FILE]\n", argv[0]);
+        return 1;
+    }
+
+    pool_book book = random_pools(opts.pools, opts.seed);
+    std::vector<std::vector<trade>> trades(book.size());
+    for (size_t p = 0; p < book.size(); p++)
+        trades[p] = random_trades(book, p, opts.trades, opts.seed + p + 1, opts.max_share);
+
+    thread_pool workers(opts.threads);
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<pool_result> results = simulate(book, trades, workers, opts.sample);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t executed = 0, rejected = 0;
+    for (const pool_result& result : results) {
+        executed += result.executed;
+        rejected += result.rejected;
+    }
+    printf("%zu pools, %llu trades executed, %llu rejected, %zu threads, %.3f s, %.0f trades/s\n",
+        book.size(), (unsigned long long)executed, (unsigned long long)rejected, workers.size(), seconds, (executed + rejected) / seconds);
+
+    if (opts.output.empty())
+        return 0;
+
+    FILE* file = fopen(opts.output.c_str(), "w");
+    if (!file) {
+        fprintf(stderr, "cannot open %s\n", opts.output.c_str());
+        return 1;
+    }
+    // one row per pool and sample: the supply and the reserve balances, then the fee revenue per reserve in the last row of the pool
+    fprintf(file, "pool,step,supply,reserve,balance,fee_revenue\n");
+    for (size_t p = 0; p < book.size(); p++) {
+        const size_t row = book.reserve_count[p] + 1;
+        const std::vector<int64_t>& trajectory = results[p].trajectory;
+        for (size_t s = 0; s * row < trajectory.size(); s++) {
+            for (size_t r = 0; r < book.reserve_count[p]; r++) {
+                const bool last = (s + 1) * row == trajectory.size();
+                fprintf(file, "%zu,%zu,%lld,%zu,%lld,", p, s * opts.sample, (long long)trajectory[s * row], r, (long long)trajectory[s * row + 1 + r]);
+                if (last)
+                    fprintf(file, "%lld", (long long)book.fee_revenue[book.first_reserve[p] + r]);
+                fprintf(file, "\n");
+            }
+        }
+    }
+    fclose(file);
+    return 0;
+}
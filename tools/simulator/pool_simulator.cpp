@@ -0,0 +1,123 @@
+#include "pool_simulator.hpp"
+
+#include <random>
+
+namespace simulator {
+
+size_t pool_book::add_pool(int64_t pool_supply, uint8_t pool_precision, uint64_t pool_fee, const std::vector<reserve_params>& reserves) {
+    eosio::check(!reserves.empty() && reserves.size() < SMART_TOKEN, "invalid number of reserves");
+    eosio::check(pool_fee <= MAX_FEE, "invalid fee");
+
+    supply.push_back(pool_supply);
+    smart_precision.push_back(pool_precision);
+    fee.push_back(pool_fee);
+    first_reserve.push_back(balance.size());
+    reserve_count.push_back(reserves.size());
+    smart_fee_revenue.push_back(0);
+
+    for (const reserve_params& reserve : reserves) {
+        eosio::check(reserve.ratio > 0 && reserve.ratio <= MAX_RATIO, "invalid ratio");
+        balance.push_back(reserve.balance);
+        precision.push_back(reserve.precision);
+        ratio.push_back(reserve.ratio);
+        curve.push_back(make_curve_coefficients(reserve.ratio));
+        fee_revenue.push_back(0);
+    }
+    return supply.size() - 1;
+}
+
+static conversion_side get_side(const pool_book& book, size_t pool, uint16_t side) {
+    if (side == SMART_TOKEN)
+        return { 0, book.smart_precision[pool], 0, true, {} };
+
+    const size_t reserve = book.first_reserve[pool] + side;
+    return { book.balance[reserve], book.precision[reserve], book.ratio[reserve], false, book.curve[reserve] };
+}
+
+bool execute_trade(pool_book& book, size_t pool, const trade& t, conversion_return* result) {
+    if (t.from == t.to || t.amount <= 0)
+        return false;
+    if ((t.from != SMART_TOKEN && t.from >= book.reserve_count[pool]) || (t.to != SMART_TOKEN && t.to >= book.reserve_count[pool]))
+        return false;
+
+    conversion_return conversion;
+    try {
+        const double smart_supply = amount_to_tokens(book.supply[pool], book.smart_precision[pool]);
+        conversion = calculate_conversion_return(get_side(book, pool, t.from), get_side(book, pool, t.to), t.amount, smart_supply, book.fee[pool]);
+    }
+    catch (const eosio::eosio_assert_exception&) { // e.g. a sale larger than the supply
+        return false;
+    }
+    if (conversion.amount <= 0)
+        return false;
+
+    if (t.from == SMART_TOKEN)
+        book.supply[pool] -= t.amount;
+    else
+        book.balance[book.first_reserve[pool] + t.from] += t.amount;
+
+    if (t.to == SMART_TOKEN) {
+        book.supply[pool] += conversion.amount;
+        book.smart_fee_revenue[pool] += conversion.fee;
+    }
+    else {
+        book.balance[book.first_reserve[pool] + t.to] -= conversion.amount;
+        book.fee_revenue[book.first_reserve[pool] + t.to] += conversion.fee;
+    }
+
+    if (result)
+        *result = conversion;
+    return true;
+}
+
+static void sample(const pool_book& book, size_t pool, std::vector<int64_t>& trajectory) {
+    trajectory.push_back(book.supply[pool]);
+    const size_t first = book.first_reserve[pool];
+    trajectory.insert(trajectory.end(), book.balance.begin() + first, book.balance.begin() + first + book.reserve_count[pool]);
+}
+
+std::vector<pool_result> simulate(pool_book& book, const std::vector<std::vector<trade>>& trades, thread_pool& workers, size_t sample_interval) {
+    eosio::check(trades.size() == book.size(), "expected the trades of every pool");
+    eosio::check(sample_interval > 0, "invalid sample interval");
+
+    std::vector<pool_result> results(book.size());
+    workers.parallel_for(book.size(), [&](size_t pool) {
+        pool_result& result = results[pool];
+        result.trajectory.reserve((trades[pool].size() / sample_interval + 1) * (book.reserve_count[pool] + 1));
+        sample(book, pool, result.trajectory);
+
+        for (size_t i = 0; i < trades[pool].size(); i++) {
+            if (execute_trade(book, pool, trades[pool][i]))
+                result.executed++;
+            else
+                result.rejected++;
+
+            if ((i + 1) % sample_interval == 0)
+                sample(book, pool, result.trajectory);
+        }
+    });
+    return results;
+}
+
+std::vector<trade> random_trades(const pool_book& book, size_t pool, size_t count, uint64_t seed, double max_share) {
+    std::mt19937_64 random(seed);
+    std::uniform_real_distribution<double> share(0, max_share);
+    const uint16_t sides = book.reserve_count[pool] + 1; // the last side is the pool token
+
+    std::vector<trade> trades;
+    trades.reserve(count);
+    while (trades.size() < count) {
+        const uint16_t from = random() % sides;
+        const uint16_t to = random() % sides;
+        if (from == to)
+            continue;
+
+        const bool smart = from == sides - 1;
+        const int64_t available = smart ? book.supply[pool] : book.balance[book.first_reserve[pool] + from];
+        const int64_t amount = std::max<int64_t>(1, int64_t(available * share(random)));
+        trades.push_back({ smart ? SMART_TOKEN : from, to == sides - 1 ? SMART_TOKEN : to, amount });
+    }
+    return trades;
+}
+
+} // namespace simulator
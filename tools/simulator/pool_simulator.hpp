@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <eosio/eosio.hpp>
+
+#include "../../src/lib/bancor_formula.hpp"
+#include "thread_pool.hpp"
+
+/**
+ * @brief off-chain simulation of legacy converter pools
+ * @details conversions go through the contract's own `calculate_conversion_return`, on the same integer amounts
+ * and the same doubles, so a simulated pool ends up with the exact balances the contract would have
+ */
+namespace simulator {
+
+/// trade side that refers to the pool token rather than to one of the reserves
+constexpr uint16_t SMART_TOKEN = UINT16_MAX;
+
+struct reserve_params {
+    int64_t balance;
+    uint8_t precision;
+    uint64_t ratio;
+};
+
+/**
+ * @brief the state of every simulated pool, as a structure of arrays
+ * @details the reserves of pool `p` are [first_reserve[p], first_reserve[p] + reserve_count[p]) in the reserve arrays,
+ * so a trade touches two adjacent cache lines at most and pools never share a reserve
+ */
+struct pool_book {
+    // per pool
+    std::vector<int64_t> supply;
+    std::vector<uint8_t> smart_precision;
+    std::vector<uint64_t> fee;
+    std::vector<uint32_t> first_reserve;
+    std::vector<uint16_t> reserve_count;
+    std::vector<int64_t> smart_fee_revenue; // pool tokens not issued because of the fee
+
+    // per reserve
+    std::vector<int64_t> balance;
+    std::vector<uint8_t> precision;
+    std::vector<uint64_t> ratio;
+    std::vector<curve_coefficients> curve;
+    std::vector<int64_t> fee_revenue;
+
+    /// adds a pool and returns its index
+    size_t add_pool(int64_t pool_supply, uint8_t pool_precision, uint64_t pool_fee, const std::vector<reserve_params>& reserves);
+
+    size_t size() const { return supply.size(); }
+};
+
+/**
+ * @brief a conversion of `amount` between two reserves of a pool, or between a reserve and the pool token (SMART_TOKEN)
+ */
+struct trade {
+    uint16_t from;
+    uint16_t to;
+    int64_t amount;
+};
+
+/**
+ * @brief what happened to a pool during a simulation
+ * @details the trajectory holds the pool supply and its reserve balances every `sample_interval` trades,
+ * starting with the initial state, as rows of 1 + reserve_count amounts
+ */
+struct pool_result {
+    uint64_t executed = 0;
+    uint64_t rejected = 0;
+    std::vector<int64_t> trajectory;
+};
+
+/// applies a trade to a pool, returns false and leaves the pool untouched when the contract would reject the conversion
+bool execute_trade(pool_book& book, size_t pool, const trade& t, conversion_return* result = nullptr);
+
+/// runs the trades of every pool, `trades[p]` in order on pool `p`, with the pools spread over the workers
+std::vector<pool_result> simulate(pool_book& book, const std::vector<std::vector<trade>>& trades, thread_pool& workers, size_t sample_interval = 1);
+
+/// random trades for a pool, each converting up to `max_share` of the initial balance (or supply) of its 'from' side
+std::vector<trade> random_trades(const pool_book& book, size_t pool, size_t count, uint64_t seed, double max_share = 0.01);
+
+} // namespace simulator
@@ -0,0 +1,115 @@
+#include "thread_pool.hpp"
+
+namespace simulator {
+
+thread_pool::thread_pool(size_t threads) {
+    if (threads == 0)
+        threads = 1;
+    for (size_t i = 0; i < threads; i++)
+        queues.push_back(std::make_unique<task_queue>());
+    for (size_t i = 0; i < threads; i++)
+        workers.emplace_back([this, i] { run(i); });
+}
+
+thread_pool::~thread_pool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+void thread_pool::parallel_for(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0)
+        return;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    // a worker still draining the previous call could otherwise run these tasks with its job
+    done.wait(lock, [this] { return active == 0; });
+    const size_t block = (count + queues.size() - 1) / queues.size();
+    for (size_t i = 0; i < queues.size(); i++) {
+        std::lock_guard<std::mutex> queue_lock(queues[i]->mutex);
+        for (size_t t = i * block; t < std::min(count, (i + 1) * block); t++)
+            queues[i]->tasks.push_back(t);
+    }
+    job = &task;
+    error = nullptr;
+    remaining = count;
+    generation++;
+    wake.notify_all();
+
+    done.wait(lock, [this] { return remaining == 0 && active == 0; });
+    job = nullptr;
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void thread_pool::run(size_t worker) {
+    uint64_t seen_generation = 0;
+    while (true) {
+        const std::function<void(size_t)>* current_job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen_generation; });
+            if (stopping)
+                return;
+            seen_generation = generation;
+            current_job = job;
+            active++;
+        }
+
+        size_t task;
+        while (pop(worker, task) || steal(worker, task)) {
+            try {
+                (*current_job)(task);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error)
+                    error = std::current_exception();
+            }
+            finish_task();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--active == 0)
+            done.notify_all();
+    }
+}
+
+bool thread_pool::pop(size_t worker, size_t& task) {
+    task_queue& queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+        return false;
+
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool thread_pool::steal(size_t worker, size_t& task) {
+    for (size_t i = 1; i < queues.size(); i++) {
+        task_queue& queue = *queues[(worker + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            continue;
+
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void thread_pool::finish_task() {
+    if (remaining.fetch_sub(1) != 1)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    done.notify_all();
+}
+
+} // namespace simulator
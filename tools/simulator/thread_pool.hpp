@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace simulator {
+
+/**
+ * @brief a fixed set of workers running independent tasks
+ * @details every `parallel_for` splits its tasks into a contiguous block per worker, a worker runs its own block
+ * from the back and steals from the front of the other workers' blocks once it runs out, so uneven tasks
+ * (e.g. pools with more trades) do not leave workers idle
+ */
+class thread_pool {
+    public:
+        explicit thread_pool(size_t threads = std::thread::hardware_concurrency());
+        ~thread_pool();
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        /// runs `task(i)` for every i in [0, count) and returns once all are done, rethrows the first exception of a task
+        void parallel_for(size_t count, const std::function<void(size_t)>& task);
+
+        size_t size() const { return workers.size(); }
+
+    private:
+        struct task_queue {
+            std::mutex mutex;
+            std::deque<size_t> tasks;
+        };
+
+        void run(size_t worker);
+        bool pop(size_t worker, size_t& task);
+        bool steal(size_t worker, size_t& task);
+        void finish_task();
+
+        std::vector<std::unique_ptr<task_queue>> queues;
+        std::vector<std::thread> workers;
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        const std::function<void(size_t)>* job = nullptr;
+        uint64_t generation = 0;
+        size_t active = 0;
+        bool stopping = false;
+        std::atomic<size_t> remaining{ 0 };
+        std::exception_ptr error;
+};
+
+} // namespace simulator